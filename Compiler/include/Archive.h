@@ -0,0 +1,81 @@
+/* 
+    Craft Compiler v0.1.0 - The standard compiler for the Craft programming language.
+    Copyright (C) 2016  Daniel McCarthy
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* 
+ * File:   Archive.h
+ * Author: Daniel McCarthy
+ *
+ * Created on 18 October 2026, 19:05
+ */
+
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include <memory>
+#include <vector>
+#include <string>
+#include <map>
+#include "Stream.h"
+#include "def.h"
+
+// Input files with this extension are archives rather than object files
+#define ARCHIVE_EXTENSION "lib"
+#define ARCHIVE_SIGNATURE "CRAFTLIB"
+#define ARCHIVE_VERSION 1
+
+struct ARCHIVE_MEMBER
+{
+    std::string name;
+    // The name of the object format the member was written in such as "omf"
+    std::string format_name;
+    // Where the member starts relative to the end of the index and its size in bytes
+    int offset;
+    int size;
+};
+
+/* A bundle of object files with an index of the global references each one defines, 
+ * the linker only loads the members it needs to define its external references */
+class EXPORT Archive
+{
+public:
+    Archive();
+    virtual ~Archive();
+
+    void addMember(std::string name, std::string format_name, std::shared_ptr<Stream> stream, std::vector<std::string> symbols);
+    void write(Stream* stream);
+    // Reads the index only, members are copied out of the stream when they are asked for
+    void read(std::shared_ptr<Stream> stream);
+
+    int getTotalMembers();
+    struct ARCHIVE_MEMBER getMember(int index);
+    std::shared_ptr<Stream> getMemberStream(int index);
+    // Returns the index of the member defining the given global reference or -1 if no member does
+    int getMemberIndexForSymbol(std::string symbol);
+private:
+    std::vector<struct ARCHIVE_MEMBER> members;
+    // Key = global reference name, value = the index of the member that defines it.
+    // Ordered so the index is always written the same way for the same members
+    std::map<std::string, int> symbol_index;
+    // The streams of members added to this archive, for archives that were read this is empty
+    std::vector<std::shared_ptr<Stream>> member_streams;
+    std::shared_ptr<Stream> archive_stream;
+    // The position the members start at in the archive stream
+    int members_start;
+};
+
+#endif /* ARCHIVE_H */
+
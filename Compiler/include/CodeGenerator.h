@@ -46,6 +46,9 @@ struct formatted_segment
 
 typedef std::map<std::string, std::string>::iterator asm_map_it;
 
+class ScopeBranch;
+class VDEFBranch;
+
 class EXPORT CodeGenerator : public CompilerEntity
 {
 public:
@@ -56,11 +59,17 @@ public:
     virtual void generate(std::shared_ptr<Tree> tree);
     virtual void assemble(std::string assembly) = 0;
     int getPointerSize();
+    virtual int getVariableAlignment(std::shared_ptr<ScopeBranch> scope_branch, std::shared_ptr<VDEFBranch> vdef_branch);
     std::shared_ptr<VirtualObjectFormat> getObjectFormat();
     std::string getName();
+    std::vector<std::string> getReport();
 
 protected:
-    void do_asm(std::string asm_ins, std::string segment = "code");
+    virtual void do_asm(std::string asm_ins, std::string segment = "code");
+    void report(std::string message);
+    // Code written to the "code" segment goes to the code segment set here instead, such as a function's own section
+    void setCodeSegment(std::string segment_name);
+    std::string getCodeSegment();
     virtual void generate_global_branch(std::shared_ptr<Branch> branch) = 0;
     virtual struct formatted_segment format_segment(std::string segment_name) = 0;
 private:
@@ -68,9 +77,13 @@ private:
             
     // Key = segment, value = assembly for segment.
     std::map<std::string, std::string> assembly;
+    std::string code_segment;
     int pointer_size;
     
     std::string code_gen_name;
+
+    // Messages describing what the code generator has done, such as optimizations it has made.
+    std::vector<std::string> report_messages;
 };
 
 #endif /* CODEGENERATOR_H */
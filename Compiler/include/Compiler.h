@@ -33,6 +33,8 @@
 #include "preprocessor.h"
 #include "SemanticValidator.h"
 #include "TreeImprover.h"
+#include "FunctionInliner.h"
+#include "DeadCodeEliminator.h"
 #include "ASTAssistant.h"
 #include "CodeGenerator.h"
 #include "Exception.h"
@@ -57,6 +59,8 @@ public:
     Preprocessor* getPreprocessor();
     SemanticValidator* getSemanticValidator();
     TreeImprover* getTreeImprover();
+    FunctionInliner* getFunctionInliner();
+    DeadCodeEliminator* getDeadCodeEliminator();
     ASTAssistant* getASTAssistant();
     std::shared_ptr<CodeGenerator> getCodeGenerator();
     std::shared_ptr<Linker> getLinker();
@@ -90,6 +94,8 @@ private:
     Preprocessor* preprocessor;
     SemanticValidator* semanticValidator;
     TreeImprover* treeImprover;
+    FunctionInliner* functionInliner;
+    DeadCodeEliminator* deadCodeEliminator;
     ASTAssistant* astAssistant;
     
     std::map<std::string, std::string> arguments;
@@ -0,0 +1,61 @@
+/* 
+    Craft Compiler v0.1.0 - The standard compiler for the Craft programming language.
+    Copyright (C) 2016  Daniel McCarthy
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* 
+ * File:   DeadCodeEliminator.h
+ * Author: Daniel McCarthy
+ *
+ * Created on 18 October 2026, 16:40
+ */
+
+#ifndef DEADCODEELIMINATOR_H
+#define DEADCODEELIMINATOR_H
+
+#include <memory>
+#include <vector>
+#include <set>
+#include <string>
+#include "CompilerEntity.h"
+
+class Tree;
+class Branch;
+class ASMBranch;
+
+class EXPORT DeadCodeEliminator : public CompilerEntity
+{
+public:
+    DeadCodeEliminator(Compiler* compiler);
+    virtual ~DeadCodeEliminator();
+
+    void setTree(std::shared_ptr<Tree> tree);
+    void eliminate();
+    std::vector<std::string> getReport();
+private:
+    void remove_unreachable_statements(std::shared_ptr<Branch> branch);
+    void find_referenced_names(std::shared_ptr<Branch> branch, std::set<std::string>* names);
+    void find_asm_referenced_names(std::shared_ptr<ASMBranch> asm_branch, std::set<std::string>* names);
+    void remove_unreferenced_global_branches(std::set<std::string>& reached_functions, std::set<std::string>& referenced_names);
+    std::string get_global_branch_name(std::shared_ptr<Branch> branch);
+
+    std::shared_ptr<Tree> tree;
+    int total_unreachable_statements;
+    // Messages describing what has been removed
+    std::vector<std::string> report_messages;
+};
+
+#endif /* DEADCODEELIMINATOR_H */
+
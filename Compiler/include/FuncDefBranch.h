@@ -39,10 +39,17 @@ public:
     void setReturnDataTypeBranch(std::shared_ptr<DataTypeBranch> returnTypeBranch);
     void setNameBranch(std::shared_ptr<Branch> nameBranch);
     void setArgumentsBranch(std::shared_ptr<FuncArgumentsBranch> argumentsBranch);
+    void setCallingConvention(std::string calling_convention);
+    void setNoInline(bool no_inline);
+    void setStatic(bool is_static);
 
     std::shared_ptr<DataTypeBranch> getReturnDataTypeBranch();
     std::shared_ptr<Branch> getNameBranch();
     std::shared_ptr<FuncArgumentsBranch> getArgumentsBranch();
+    std::string getCallingConvention();
+    bool isRegisterCall();
+    bool isNoInline();
+    bool isStatic();
     
     virtual bool isOnlyDefinition();
 
@@ -51,7 +58,12 @@ public:
 
 
 private:
-
+    // The calling convention attribute this function was declared with e.g "__regcall", blank if none was given.
+    std::string calling_convention;
+    // True if this function was declared with "__noinline" and so must never be inlined.
+    bool no_inline;
+    // True if this function was declared with "__static" and so is not visible outside of its own file.
+    bool is_static;
 };
 
 #endif /* FUNCDEFBRANCH_H */
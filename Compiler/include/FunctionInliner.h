@@ -0,0 +1,79 @@
+/* 
+    Craft Compiler v0.1.0 - The standard compiler for the Craft programming language.
+    Copyright (C) 2016  Daniel McCarthy
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* 
+ * File:   FunctionInliner.h
+ * Author: Daniel McCarthy
+ *
+ * Created on 18 October 2026, 10:12
+ */
+
+#ifndef FUNCTIONINLINER_H
+#define FUNCTIONINLINER_H
+
+#include <memory>
+#include <vector>
+#include <map>
+#include <set>
+#include <string>
+#include "CompilerEntity.h"
+
+// Functions made of no more than this many branches are inlined at every call site they can be
+#define INLINE_MAX_FUNCTION_BRANCHES 24
+// As above but for when we are optimizing for size with "-Os"
+#define INLINE_MAX_FUNCTION_BRANCHES_FOR_SIZE 6
+
+class Tree;
+class Branch;
+class ScopeBranch;
+class FuncBranch;
+class FuncCallBranch;
+class IFBranch;
+
+class EXPORT FunctionInliner : public CompilerEntity
+{
+public:
+    FunctionInliner(Compiler* compiler);
+    virtual ~FunctionInliner();
+
+    void setTree(std::shared_ptr<Tree> tree);
+    void inline_functions();
+    int getTotalInlinedCalls();
+private:
+    void find_call_statements(std::shared_ptr<Branch> branch, std::vector<std::shared_ptr<Branch>>* stmt_branches);
+    bool inline_call(std::shared_ptr<FuncBranch> caller_func_branch, std::shared_ptr<Branch> stmt_branch, std::shared_ptr<FuncCallBranch> func_call_branch);
+    std::shared_ptr<FuncCallBranch> get_inlinable_call(std::shared_ptr<Branch> stmt_branch);
+    std::shared_ptr<FuncBranch> get_inlinable_function(std::string func_name);
+    bool is_inlinable_body(std::shared_ptr<Branch> body_branch, bool is_function_body = true);
+    bool is_inlinable_if(std::shared_ptr<IFBranch> if_branch);
+    bool has_side_effects(std::shared_ptr<Branch> branch);
+    int count_branches(std::shared_ptr<Branch> branch);
+    void count_call_sites(std::shared_ptr<Branch> branch);
+    void get_declared_names(std::shared_ptr<Branch> branch, std::set<std::string>* names);
+    void get_var_names(std::shared_ptr<Branch> branch, std::set<std::string>* names, bool is_struct_member = false);
+    void rename_vars(std::shared_ptr<Branch> branch, std::map<std::string, std::string>& new_names, bool is_struct_member = false);
+    void move_scopes(std::shared_ptr<Branch> branch, std::map<std::shared_ptr<ScopeBranch>, std::shared_ptr<ScopeBranch>>& new_scopes, std::shared_ptr<ScopeBranch> old_scope, std::shared_ptr<ScopeBranch> old_args_scope, std::shared_ptr<ScopeBranch> new_root_scope);
+    int getMaxFunctionBranches();
+
+    std::shared_ptr<Tree> tree;
+    // Key = function name, value = amount of times it is called in this tree
+    std::map<std::string, int> call_sites;
+    int total_inlined_calls;
+};
+
+#endif /* FUNCTIONINLINER_H */
+
@@ -28,7 +28,11 @@
 #include <vector>
 #include <fstream>
 #include <deque>
+#include <set>
+#include <map>
+#include <string>
 #include <memory>
+#include <functional>
 #include "Stream.h"
 #include "Exception.h"
 #include "LinkerException.h"
@@ -36,6 +40,12 @@
 #include "CompilerEntity.h"
 
 class VirtualObjectFormat;
+class VirtualSegment;
+class FIXUP;
+class Archive;
+
+// Creates an empty object format of the given name such as "omf", used to read archive members
+typedef std::function<std::shared_ptr<VirtualObjectFormat>(std::string format_name)> ObjectFormatFactory;
 
 class EXPORT Linker : public CompilerEntity
 {
@@ -44,15 +54,43 @@ public:
     virtual ~Linker();
     void addObjectFile(std::shared_ptr<VirtualObjectFormat> obj);
     bool hasObjectFile(std::shared_ptr<VirtualObjectFormat> obj);
+    void addArchive(std::shared_ptr<Archive> archive);
+    void setObjectFormatFactory(ObjectFormatFactory object_format_factory);
     void link();
     Stream* getExecutableStream();
+    std::vector<std::string> getReport();
+    std::vector<std::string> getWarnings();
 protected:
+    void report(std::string message);
+    void warn(std::string message);
+    // The fixups of a segment in the order they appear in it so they are applied in one pass over its bytes
+    std::vector<std::shared_ptr<FIXUP>> get_sorted_fixups(std::shared_ptr<VirtualSegment> segment);
+    // Reads the value currently at the fixup, self relative fixups are signed
+    int read_fixup(std::shared_ptr<VirtualSegment> segment, char* buf, std::shared_ptr<FIXUP> fixup);
+    // Writes the value at the fixup, throws should the value not fit the length of the fixup
+    void apply_fixup(std::shared_ptr<VirtualSegment> segment, char* buf, std::shared_ptr<FIXUP> fixup, int value);
     virtual void link_merge(std::shared_ptr<VirtualObjectFormat> obj1, std::shared_ptr<VirtualObjectFormat> obj2);
+    // Segments that are kept even when nothing refers to them, by default everything but function sections
+    virtual bool is_root_segment(std::shared_ptr<VirtualSegment> segment);
     virtual void resolve(std::shared_ptr<VirtualObjectFormat> final_obj) = 0;
     virtual void build(Stream* executable_stream, std::shared_ptr<VirtualObjectFormat> final_obj) = 0;
 private:
+    void pull_archive_members(std::shared_ptr<VirtualObjectFormat> final_obj);
+    void collect_garbage(std::shared_ptr<VirtualObjectFormat> final_obj);
+    void check_fixup_bounds(std::shared_ptr<VirtualSegment> segment, std::shared_ptr<FIXUP> fixup);
+    std::string get_fixup_target_name(std::shared_ptr<FIXUP> fixup);
+    std::string get_symbol_at(std::shared_ptr<VirtualSegment> segment, int offset);
+    void mark_segment(std::shared_ptr<VirtualObjectFormat> final_obj, std::shared_ptr<VirtualSegment> segment, std::set<std::shared_ptr<VirtualSegment>>* marked_segments);
+
     std::deque<std::shared_ptr<VirtualObjectFormat>> obj_stack;
     Stream executable_stream;
+    std::vector<std::shared_ptr<Archive>> archives;
+    ObjectFormatFactory object_format_factory;
+
+    // Messages describing what the linker has done, such as segments it has removed.
+    std::vector<std::string> report_messages;
+    // Messages about things that link but may not behave as expected, these are always shown
+    std::vector<std::string> warning_messages;
 };
 
 #endif /* LINKER_H */
@@ -115,6 +115,9 @@ private:
     void process_structure();
     void process_structure_declaration();
     void process_while_stmt();
+    void process_switch_stmt();
+    void process_case();
+    void process_default();
     void process_for_stmt();
     void process_array_indexes();
     void process_semicolon();
@@ -193,6 +196,12 @@ private:
     std::shared_ptr<FuncBranch> current_function;
 
     bool did_return;
+    // The calling convention attribute given for the next function to be processed
+    std::string calling_convention;
+    // True if the next function to be processed was given the "__noinline" attribute
+    bool no_inline;
+    // True if the next function to be processed was given the "__static" attribute
+    bool is_static;
     Compiler* compiler;
     std::shared_ptr<Tree> tree;
 };
@@ -27,6 +27,7 @@
 
 #include <memory>
 #include <map>
+#include <set>
 #include "CompilerEntity.h"
 #include "SemanticValidatorException.h"
 #include "Logger.h"
@@ -56,6 +57,7 @@ class RootBranch;
 class VDEFBranch;
 class ReturnBranch;
 class WhileBranch;
+class SwitchBranch;
 class IFBranch;
 class AddressOfBranch;
 class BODYBranch;
@@ -93,11 +95,13 @@ private:
     void validate_vdef(std::shared_ptr<VDEFBranch> vdef_branch);
     void validate_return(std::shared_ptr<ReturnBranch> return_branch);
     void validate_while_loop(std::shared_ptr<WhileBranch> while_branch);
+    void validate_switch_stmt(std::shared_ptr<SwitchBranch> switch_branch);
     void validate_if_stmt(std::shared_ptr<IFBranch> if_branch);
     void validate_address_of(std::shared_ptr<AddressOfBranch> address_of_branch);
     void validate_var_access(std::shared_ptr<VarIdentifierBranch> var_iden_branch);
     bool validate_pointer_access(std::shared_ptr<PTRBranch> ptr_branch);
     void validate_assignment(std::shared_ptr<AssignBranch> assign_branch);
+    void validate_structure_assignment(std::shared_ptr<AssignBranch> assign_branch, std::shared_ptr<VDEFBranch> vdef_branch);
     void validate_for_stmt(std::shared_ptr<FORBranch> for_branch);
     void validate_function_call(std::shared_ptr<FuncCallBranch> func_call_branch);
     void validate_structure_definition(std::shared_ptr<STRUCTDEFBranch> struct_def_branch);
@@ -50,6 +50,7 @@ public:
     void write32(uint32_t i);
     void writeStr(std::string str, bool write_null_terminator = true, size_t fill_to = -1);
     void writeStr(const char* str, bool write_null_terminator = true, size_t fill_to = -1);
+    void writeBuf(const char* buf, size_t size);
     void writeStream(Stream* stream, int offset = -1, int total = -1);
     void writeStream(std::shared_ptr<Stream> stream, int offset = -1, int total = -1);
     void joinStream(std::shared_ptr<Stream> stream);
@@ -27,7 +27,17 @@
 
 #include <memory>
 #include <vector>
+#include <functional>
 #include "CompilerEntity.h"
+
+// The byte budget for loop unrolling when none is given with "-unroll_budget"
+#define UNROLL_DEFAULT_BYTE_BUDGET 96
+/* We do not know the target at this stage so we estimate the code size of a loop body
+ * by assuming every branch will produce a few bytes of code */
+#define UNROLL_ESTIMATED_BYTES_PER_BRANCH 3
+// Loops that iterate more than this many times are never considered for unrolling
+#define UNROLL_MAX_TRIP_COUNT 256
+
 class Tree;
 class Branch;
 class FuncBranch;
@@ -37,7 +47,9 @@ class VarIdentifierBranch;
 class BODYBranch;
 class IFBranch;
 class WhileBranch;
+class SwitchBranch;
 class FORBranch;
+class VDEFBranch;
 class PTRBranch;
 class STRUCTDEFBranch;
 
@@ -63,6 +75,8 @@ public:
     void setTree(std::shared_ptr<Tree> tree);
     void improve();
     void improve_expression(std::shared_ptr<EBranch> expression_branch, struct improvement* improvement, bool is_root = true);
+    int getTotalUnrolledLoops();
+    int getTotalFullyUnrolledLoops();
 private:
     void improve_top(struct improvement* improvement);
     void improve_branch(std::shared_ptr<Branch> branch, struct improvement* improvement);
@@ -73,11 +87,22 @@ private:
     void improve_var_iden(std::shared_ptr<VarIdentifierBranch> var_iden_branch, struct improvement* improvement);
     void improve_if(std::shared_ptr<IFBranch> if_branch, struct improvement* improvement);
     void improve_while(std::shared_ptr<WhileBranch> while_branch, struct improvement* improvement);
+    void improve_switch(std::shared_ptr<SwitchBranch> switch_branch, struct improvement* improvement);
     void improve_for(std::shared_ptr<FORBranch> for_branch, struct improvement* improvement);
     void improve_ptr(std::shared_ptr<PTRBranch> ptr_branch, struct improvement* improvement);
 
+    bool unroll_for(std::shared_ptr<FORBranch> for_branch, struct improvement* improvement);
+    bool get_unroll_trip_values(std::shared_ptr<FORBranch> for_branch, std::vector<int>* values);
+    bool is_unrollable_body(std::shared_ptr<Branch> branch, std::string index_name);
+    bool is_index_var_iden(std::shared_ptr<Branch> branch, std::string index_name);
+    int estimate_code_size(std::shared_ptr<Branch> branch);
+    std::shared_ptr<Branch> clone_with_index(std::shared_ptr<Branch> branch, std::string index_name, std::function<std::shared_ptr<Branch>() > make_index_branch);
+    int getUnrollByteBudget();
+
     std::shared_ptr<Tree> tree;
     VARIABLE_TYPE current_var_type;
+    int total_unrolled_loops;
+    int total_fully_unrolled_loops;
 
 
 };
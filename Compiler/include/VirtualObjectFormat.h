@@ -26,6 +26,8 @@
 #define VIRTUALOBJECTFORMAT_H
 
 #include <vector>
+#include <string>
+#include <unordered_map>
 #include <memory>
 
 #include "VirtualSegment.h"
@@ -44,6 +46,9 @@ public:
     std::vector<std::shared_ptr<VirtualSegment>> getSegments();
 
     bool hasSegment(std::string segment_name);
+    void removeSegment(std::shared_ptr<VirtualSegment> segment);
+    // The position the given segment starts at in our segment of the same name, it may have come from an object file appended to us
+    int getSegmentPosition(std::shared_ptr<VirtualSegment> segment);
     
     void registerGlobalReference(std::shared_ptr<VirtualSegment> segment, std::string ref_name, int offset);
     std::vector<std::shared_ptr<GLOBAL_REF>> getGlobalReferences();
@@ -68,6 +73,8 @@ private:
     Stream object_stream;
     std::vector<std::shared_ptr<VirtualSegment>> segments;
     std::vector<std::string> external_references;
+    // Key = global reference name, value = the global reference so they can be found without searching every segment
+    std::unordered_map<std::string, std::shared_ptr<GLOBAL_REF>> global_reference_table;
 };
 
 #endif /* VIRTUALOBJECTFORMAT_H */
@@ -27,6 +27,7 @@
 
 #include <vector>
 #include <string>
+#include <map>
 #include <memory>
 #include "Stream.h"
 #include "def.h"
@@ -128,30 +129,63 @@ public:
     virtual ~VirtualSegment();
     std::string getName();
     std::shared_ptr<Stream> getStream();
+    // Replaces the bytes of this segment and of any segments appended to it, fixups and global references are left as they are
+    void setStream(std::shared_ptr<Stream> stream);
+
+    /* Appends the given segment on its alignment without copying it. It keeps its own bytes, fixups and global references
+     * which are relative to where it starts, the linker adds its position when it needs them relative to this segment */
+    void appendSegment(std::shared_ptr<VirtualSegment> segment);
+    // This segment followed by every segment appended to it
+    std::vector<std::shared_ptr<VirtualSegment>> getParts();
+    // The position the given part starts at in this segment, this segment itself and segments never appended start at zero
+    int getPartPosition(std::shared_ptr<VirtualSegment> segment);
+    bool hasAppendedSegments();
+    // Copies the bytes, fixups and global references of the appended segments into this one, their positions are still remembered
+    void materialize();
 
     void register_fixup(std::shared_ptr<FIXUP_TARGET> fixup_target, FIXUP_TYPE fixup_type, int offset, FIXUP_LENGTH length);
     void register_fixup_target_segment(FIXUP_TYPE fixup_type, std::shared_ptr<VirtualSegment> relating_segment, int offset, FIXUP_LENGTH length);
     void register_fixup_target_extern(FIXUP_TYPE fixup_type, std::string extern_name, int offset, FIXUP_LENGTH length);
-    void register_global_reference(std::string ref_name, int offset);
+    std::shared_ptr<GLOBAL_REF> register_global_reference(std::string ref_name, int offset);
     std::vector<std::shared_ptr<FIXUP>> getFixups();
     bool hasFixups();
 
-    std::vector<std::shared_ptr<GLOBAL_REF>> getGlobalReferences();
+    const std::vector<std::shared_ptr<GLOBAL_REF>>& getGlobalReferences();
     std::shared_ptr<GLOBAL_REF> getGlobalReferenceByName(std::string ref_name);
 
     bool hasGlobalReferences();
     bool hasGlobalReference(std::string ref_name);
 
+    // Function sections hold a single function and may be removed by the linker when nothing refers to them
+    bool isFunctionSection();
+
     bool hasOrigin();
     uint32_t getOrigin();
 
+    // The boundary in bytes that the start of this segment must be placed on when linked, 1 if it can start anywhere
+    void setAlignment(int alignment);
+    int getAlignment();
+
+    // Uninitialized segments such as "bss" store no bytes, only their size. They are zero when the program starts
+    void setUninitialized(bool uninitialized);
+    bool isUninitialized();
+    // Reserves zeroed bytes at the end of this segment, they are only written to the stream when this segment is initialized
+    void reserve(int size);
+    int getSize();
+
 private:
     std::vector<std::shared_ptr<FIXUP>> fixups;
     std::vector<std::shared_ptr<GLOBAL_REF>> global_references;
     std::string segment_name;
     std::shared_ptr<Stream> stream;
+    std::vector<std::shared_ptr<VirtualSegment>> appended_segments;
+    // Key = a segment appended to this one, value = the position it starts at
+    std::map<std::shared_ptr<VirtualSegment>, int> part_positions;
 
     uint32_t origin;
+    int alignment;
+    bool uninitialized;
+    int uninitialized_size;
 };
 
 #endif /* VIRTUALSEGMENT_H */
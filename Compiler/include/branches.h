@@ -55,6 +55,9 @@
 #include "BreakBranch.h"
 #include "ContinueBranch.h"
 #include "WhileBranch.h"
+#include "SwitchBranch.h"
+#include "CaseBranch.h"
+#include "DefaultBranch.h"
 #include "ReturnBranch.h"
 #include "MacroStmtExpBodyBranch.h"
 #include "MacroIfNDefBranch.h"
@@ -55,6 +55,9 @@ void EXPORT debug_virtual_object_format(std::shared_ptr<VirtualObjectFormat> vir
 void EXPORT WriteFile(std::string filename, Stream* stream);
 
 int EXPORT GetFixupLengthAsInteger(FIXUP_LENGTH fixup_len);
+// Little endian reads and writes of a value the size of the fixup length
+int EXPORT ReadFixupValue(const char* buf, FIXUP_LENGTH fixup_len, bool is_signed);
+void EXPORT WriteFixupValue(char* buf, FIXUP_LENGTH fixup_len, int value);
 std::string EXPORT GetCompilerName();
 #endif /* COMMON_H */
 
@@ -38,6 +38,10 @@
 #define OBJ_FORMAT_DIR "./obj_formats"
 #define LINKER_DIR "./linkers"
 
+/* With "-function_sections" each function other than the first is placed in a segment named this followed by the function name.
+ * Linkers may remove any of these segments that nothing refers to */
+#define FUNCTION_SECTION_PREFIX "code_"
+
 // If its a CYGWIN compiler then enable _WIN32
 #ifdef __CYGWIN__
 #define _WIN32
@@ -40,18 +40,22 @@ OBJECTFILES= \
 	${OBJECTDIR}/src/ASMBranch.o \
 	${OBJECTDIR}/src/ASTAssistant.o \
 	${OBJECTDIR}/src/AddressOfBranch.o \
+	${OBJECTDIR}/src/Archive.o \
 	${OBJECTDIR}/src/ArrayIndexBranch.o \
 	${OBJECTDIR}/src/Assembler.o \
 	${OBJECTDIR}/src/AssignBranch.o \
 	${OBJECTDIR}/src/BODYBranch.o \
 	${OBJECTDIR}/src/Branch.o \
 	${OBJECTDIR}/src/BreakBranch.o \
+	${OBJECTDIR}/src/CaseBranch.o \
 	${OBJECTDIR}/src/CodeGenerator.o \
 	${OBJECTDIR}/src/Compiler.o \
 	${OBJECTDIR}/src/CompilerEntity.o \
 	${OBJECTDIR}/src/ContinueBranch.o \
 	${OBJECTDIR}/src/CustomBranch.o \
 	${OBJECTDIR}/src/DataTypeBranch.o \
+	${OBJECTDIR}/src/DeadCodeEliminator.o \
+	${OBJECTDIR}/src/DefaultBranch.o \
 	${OBJECTDIR}/src/EBranch.o \
 	${OBJECTDIR}/src/ELSEBranch.o \
 	${OBJECTDIR}/src/FORBranch.o \
@@ -59,6 +63,7 @@ OBJECTFILES= \
 	${OBJECTDIR}/src/FuncBranch.o \
 	${OBJECTDIR}/src/FuncCallBranch.o \
 	${OBJECTDIR}/src/FuncDefBranch.o \
+	${OBJECTDIR}/src/FunctionInliner.o \
 	${OBJECTDIR}/src/Helper.o \
 	${OBJECTDIR}/src/IFBranch.o \
 	${OBJECTDIR}/src/Lexer.o \
@@ -85,6 +90,7 @@ OBJECTFILES= \
 	${OBJECTDIR}/src/SemanticValidator.o \
 	${OBJECTDIR}/src/StandardScopeBranch.o \
 	${OBJECTDIR}/src/Stream.o \
+	${OBJECTDIR}/src/SwitchBranch.o \
 	${OBJECTDIR}/src/Token.o \
 	${OBJECTDIR}/src/Tree.o \
 	${OBJECTDIR}/src/TreeImprover.o \
@@ -145,6 +151,11 @@ ${OBJECTDIR}/src/AddressOfBranch.o: src/AddressOfBranch.cpp
 	${RM} "$@.d"
 	$(COMPILE.cc) -g -DDEBUG_MODE -Iinclude -std=c++14  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/AddressOfBranch.o src/AddressOfBranch.cpp
 
+${OBJECTDIR}/src/Archive.o: src/Archive.cpp
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -DDEBUG_MODE -Iinclude -std=c++14  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/Archive.o src/Archive.cpp
+
 ${OBJECTDIR}/src/ArrayIndexBranch.o: src/ArrayIndexBranch.cpp
 	${MKDIR} -p ${OBJECTDIR}/src
 	${RM} "$@.d"
@@ -175,6 +186,11 @@ ${OBJECTDIR}/src/BreakBranch.o: src/BreakBranch.cpp
 	${RM} "$@.d"
 	$(COMPILE.cc) -g -DDEBUG_MODE -Iinclude -std=c++14  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/BreakBranch.o src/BreakBranch.cpp
 
+${OBJECTDIR}/src/CaseBranch.o: src/CaseBranch.cpp
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -DDEBUG_MODE -Iinclude -std=c++14  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/CaseBranch.o src/CaseBranch.cpp
+
 ${OBJECTDIR}/src/CodeGenerator.o: src/CodeGenerator.cpp
 	${MKDIR} -p ${OBJECTDIR}/src
 	${RM} "$@.d"
@@ -205,6 +221,16 @@ ${OBJECTDIR}/src/DataTypeBranch.o: src/DataTypeBranch.cpp
 	${RM} "$@.d"
 	$(COMPILE.cc) -g -DDEBUG_MODE -Iinclude -std=c++14  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/DataTypeBranch.o src/DataTypeBranch.cpp
 
+${OBJECTDIR}/src/DeadCodeEliminator.o: src/DeadCodeEliminator.cpp
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -DDEBUG_MODE -Iinclude -std=c++14  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/DeadCodeEliminator.o src/DeadCodeEliminator.cpp
+
+${OBJECTDIR}/src/DefaultBranch.o: src/DefaultBranch.cpp
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -DDEBUG_MODE -Iinclude -std=c++14  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/DefaultBranch.o src/DefaultBranch.cpp
+
 ${OBJECTDIR}/src/EBranch.o: src/EBranch.cpp
 	${MKDIR} -p ${OBJECTDIR}/src
 	${RM} "$@.d"
@@ -240,6 +266,11 @@ ${OBJECTDIR}/src/FuncDefBranch.o: src/FuncDefBranch.cpp
 	${RM} "$@.d"
 	$(COMPILE.cc) -g -DDEBUG_MODE -Iinclude -std=c++14  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/FuncDefBranch.o src/FuncDefBranch.cpp
 
+${OBJECTDIR}/src/FunctionInliner.o: src/FunctionInliner.cpp
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -DDEBUG_MODE -Iinclude -std=c++14  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/FunctionInliner.o src/FunctionInliner.cpp
+
 ${OBJECTDIR}/src/Helper.o: src/Helper.cpp
 	${MKDIR} -p ${OBJECTDIR}/src
 	${RM} "$@.d"
@@ -370,6 +401,11 @@ ${OBJECTDIR}/src/Stream.o: src/Stream.cpp
 	${RM} "$@.d"
 	$(COMPILE.cc) -g -DDEBUG_MODE -Iinclude -std=c++14  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/Stream.o src/Stream.cpp
 
+${OBJECTDIR}/src/SwitchBranch.o: src/SwitchBranch.cpp
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -DDEBUG_MODE -Iinclude -std=c++14  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/SwitchBranch.o src/SwitchBranch.cpp
+
 ${OBJECTDIR}/src/Token.o: src/Token.cpp
 	${MKDIR} -p ${OBJECTDIR}/src
 	${RM} "$@.d"
@@ -0,0 +1,190 @@
+/*
+    Craft Compiler v0.1.0 - The standard compiler for the Craft programming language.
+    Copyright (C) 2016  Daniel McCarthy
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Archive.cpp
+ * Author: Daniel McCarthy
+ *
+ * Created on 18 October 2026, 19:05
+ *
+ * Description: Reads and writes archives of object files.
+ * 
+ * An archive starts with its signature, version, the total members and the total symbols.
+ * Each member follows as its name, object format name, offset and size, then each symbol in name order as its name and member index.
+ * The members are written last one after another. Strings are null terminated and numbers are little endian.
+ */
+
+#include "Archive.h"
+#include "Exception.h"
+
+Archive::Archive()
+{
+    this->members_start = 0;
+}
+
+Archive::~Archive()
+{
+}
+
+void Archive::addMember(std::string name, std::string format_name, std::shared_ptr<Stream> stream, std::vector<std::string> symbols)
+{
+    int index = this->members.size();
+    for (std::string symbol : symbols)
+    {
+        int defining_index = getMemberIndexForSymbol(symbol);
+        if (defining_index != -1 && defining_index != index)
+        {
+            throw Exception("Duplicate definition: " + symbol + " is defined by both " + this->members[defining_index].name + " and " + name, "void Archive::addMember(std::string name, std::string format_name, std::shared_ptr<Stream> stream, std::vector<std::string> symbols)");
+        }
+        this->symbol_index[symbol] = index;
+    }
+
+    struct ARCHIVE_MEMBER member;
+    member.name = name;
+    member.format_name = format_name;
+    member.offset = 0;
+    if (!this->members.empty())
+    {
+        member.offset = this->members.back().offset + this->members.back().size;
+    }
+    member.size = stream->getSize();
+    this->members.push_back(member);
+    this->member_streams.push_back(stream);
+}
+
+void Archive::write(Stream* stream)
+{
+    stream->writeStr(ARCHIVE_SIGNATURE, false);
+    stream->write16(ARCHIVE_VERSION);
+    stream->write32(this->members.size());
+    stream->write32(this->symbol_index.size());
+    for (struct ARCHIVE_MEMBER member : this->members)
+    {
+        stream->writeStr(member.name);
+        stream->writeStr(member.format_name);
+        stream->write32(member.offset);
+        stream->write32(member.size);
+    }
+
+    for (std::pair<std::string, int> symbol : this->symbol_index)
+    {
+        stream->writeStr(symbol.first);
+        stream->write32(symbol.second);
+    }
+
+    for (std::shared_ptr<Stream> member_stream : this->member_streams)
+    {
+        stream->writeStream(member_stream);
+    }
+}
+
+void Archive::read(std::shared_ptr<Stream> stream)
+{
+    // Streams are left positioned at their end once loaded
+    stream->setPosition(0);
+    std::string signature = "";
+    for (size_t i = 0; i < std::string(ARCHIVE_SIGNATURE).length(); i++)
+    {
+        signature += stream->read8();
+    }
+
+    if (signature != ARCHIVE_SIGNATURE)
+    {
+        throw Exception("The stream is not an archive", "void Archive::read(std::shared_ptr<Stream> stream)");
+    }
+
+    int version = stream->read16();
+    if (version != ARCHIVE_VERSION)
+    {
+        throw Exception("Archives of version " + std::to_string(version) + " are not supported", "void Archive::read(std::shared_ptr<Stream> stream)");
+    }
+
+    int total_members = stream->read32();
+    int total_symbols = stream->read32();
+    if (total_members < 0 || total_symbols < 0)
+    {
+        throw Exception("The archive states a negative number of members or symbols", "void Archive::read(std::shared_ptr<Stream> stream)");
+    }
+
+    for (int i = 0; i < total_members; i++)
+    {
+        struct ARCHIVE_MEMBER member;
+        member.name = stream->readStr();
+        member.format_name = stream->readStr();
+        member.offset = stream->read32();
+        member.size = stream->read32();
+        if (member.offset < 0 || member.size < 0)
+        {
+            throw Exception("The member: " + member.name + " has a negative offset or size", "void Archive::read(std::shared_ptr<Stream> stream)");
+        }
+        this->members.push_back(member);
+    }
+
+    for (int i = 0; i < total_symbols; i++)
+    {
+        std::string symbol = stream->readStr();
+        int index = stream->read32();
+        if (index < 0 || index >= total_members)
+        {
+            throw Exception("The symbol: " + symbol + " belongs to a member that does not exist", "void Archive::read(std::shared_ptr<Stream> stream)");
+        }
+        this->symbol_index[symbol] = index;
+    }
+
+    this->archive_stream = stream;
+    this->members_start = stream->getPosition();
+}
+
+int Archive::getTotalMembers()
+{
+    return this->members.size();
+}
+
+struct ARCHIVE_MEMBER Archive::getMember(int index)
+{
+    return this->members.at(index);
+}
+
+std::shared_ptr<Stream> Archive::getMemberStream(int index)
+{
+    if (index < (int) this->member_streams.size())
+    {
+        return this->member_streams[index];
+    }
+
+    struct ARCHIVE_MEMBER member = getMember(index);
+    if ((size_t) this->members_start + member.offset + member.size > this->archive_stream->getSize())
+    {
+        throw Exception("The member: " + member.name + " goes beyond the end of the archive", "std::shared_ptr<Stream> Archive::getMemberStream(int index)");
+    }
+
+    std::shared_ptr<Stream> stream = std::shared_ptr<Stream>(new Stream());
+    stream->writeStream(this->archive_stream, this->members_start + member.offset, member.size);
+    stream->setPosition(0);
+    return stream;
+}
+
+int Archive::getMemberIndexForSymbol(std::string symbol)
+{
+    std::map<std::string, int>::iterator it = this->symbol_index.find(symbol);
+    if (it == this->symbol_index.end())
+    {
+        return -1;
+    }
+
+    return it->second;
+}
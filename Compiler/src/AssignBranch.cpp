@@ -69,6 +69,8 @@ std::string AssignBranch::getOperator()
 void AssignBranch::imp_clone(std::shared_ptr<Branch> cloned_branch)
 {
     std::shared_ptr<AssignBranch> assign_branch_cloned = std::dynamic_pointer_cast<AssignBranch>(cloned_branch);
+    // The assign operator is the value of this branch
+    assign_branch_cloned->setValue(getValue());
     assign_branch_cloned->setValueBranch(getValueBranch()->clone());
     assign_branch_cloned->setVariableToAssignBranch(std::dynamic_pointer_cast<VarIdentifierBranch>(getVariableToAssignBranch()->clone()));
 }
@@ -0,0 +1,56 @@
+/*
+    Craft compiler v0.1.0 - The standard compiler for the Craft programming language.
+    Copyright (C) 2016  Daniel McCarthy
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* 
+ * File:   CaseBranch.cpp
+ * Author: Daniel McCarthy
+ *
+ * Created on 18 October 2026, 14:20
+ * 
+ * Description: Marks where a switch statement jumps to when its expression equals the value of this case.
+ */
+
+#include "CaseBranch.h"
+
+CaseBranch::CaseBranch(Compiler* compiler) : CustomBranch(compiler, "CASE", "")
+{
+}
+
+CaseBranch::~CaseBranch()
+{
+}
+
+void CaseBranch::setValueBranch(std::shared_ptr<Branch> value_branch)
+{
+    CustomBranch::registerBranch("value_branch", value_branch);
+}
+
+std::shared_ptr<Branch> CaseBranch::getValueBranch()
+{
+    return CustomBranch::getRegisteredBranchByName("value_branch");
+}
+
+void CaseBranch::imp_clone(std::shared_ptr<Branch> cloned_branch)
+{
+    std::shared_ptr<CaseBranch> case_branch_cloned = std::dynamic_pointer_cast<CaseBranch>(cloned_branch);
+    case_branch_cloned->setValueBranch(getValueBranch()->clone());
+}
+
+std::shared_ptr<Branch> CaseBranch::create_clone()
+{
+    return std::shared_ptr<Branch>(new CaseBranch(getCompiler()));
+}
\ No newline at end of file
@@ -35,6 +35,7 @@ CodeGenerator::CodeGenerator(Compiler* compiler, std::shared_ptr<VirtualObjectFo
     this->pointer_size = pointer_size;
     this->object_format = object_format;
     this->code_gen_name = code_gen_name;
+    this->code_segment = "code";
 }
 
 CodeGenerator::~CodeGenerator()
@@ -71,6 +72,13 @@ int CodeGenerator::getPointerSize()
     return this->pointer_size;
 }
 
+/* Returns the boundary in bytes that the given variable must start on within the given scope.
+ * Code generators whose target benefits from aligned data should override this, by default nothing is aligned.*/
+int CodeGenerator::getVariableAlignment(std::shared_ptr<ScopeBranch> scope_branch, std::shared_ptr<VDEFBranch> vdef_branch)
+{
+    return 1;
+}
+
 std::shared_ptr<VirtualObjectFormat> CodeGenerator::getObjectFormat()
 {
     return this->object_format;
@@ -81,8 +89,18 @@ std::string CodeGenerator::getName()
     return this->code_gen_name;
 }
 
+std::vector<std::string> CodeGenerator::getReport()
+{
+    return this->report_messages;
+}
+
 void CodeGenerator::do_asm(std::string asm_ins, std::string segment)
 {
+    if (segment == "code")
+    {
+        segment = this->code_segment;
+    }
+
     std::map<std::string, std::string>::const_iterator it = this->assembly.find(segment);
     bool exists = it != this->assembly.end();
 
@@ -96,4 +114,19 @@ void CodeGenerator::do_asm(std::string asm_ins, std::string segment)
 
     this->assembly[segment] = asm_str;
 
-}
\ No newline at end of file
+}
+
+void CodeGenerator::report(std::string message)
+{
+    this->report_messages.push_back(message);
+}
+
+void CodeGenerator::setCodeSegment(std::string segment_name)
+{
+    this->code_segment = segment_name;
+}
+
+std::string CodeGenerator::getCodeSegment()
+{
+    return this->code_segment;
+}
@@ -36,6 +36,8 @@ Compiler::Compiler()
     this->semanticValidator = new SemanticValidator(this);
     this->astAssistant = new ASTAssistant(this);
     this->treeImprover = new TreeImprover(this);
+    this->functionInliner = new FunctionInliner(this);
+    this->deadCodeEliminator = new DeadCodeEliminator(this);
     this->codeGenerator = NULL;
     this->linker = NULL;
 }
@@ -90,6 +92,16 @@ TreeImprover* Compiler::getTreeImprover()
     return this->treeImprover;
 }
 
+FunctionInliner* Compiler::getFunctionInliner()
+{
+    return this->functionInliner;
+}
+
+DeadCodeEliminator* Compiler::getDeadCodeEliminator()
+{
+    return this->deadCodeEliminator;
+}
+
 ASTAssistant* Compiler::getASTAssistant()
 {
     return this->astAssistant;
@@ -195,23 +207,25 @@ int Compiler::getDataTypeSizeFromVarDef(std::shared_ptr<VDEFBranch> branch, bool
 
 int Compiler::getSizeOfStructure(std::shared_ptr<STRUCTBranch> structure)
 {
-    int t_size = 0;
-    for (std::shared_ptr<Branch> struct_branch_child : structure->getStructBodyBranch()->getChildren())
+    std::shared_ptr<BODYBranch> struct_body_branch = structure->getStructBodyBranch();
+    // The body scope size includes any padding the code generator places between members
+    int t_size = struct_body_branch->getScopeSize();
+
+    // Pad the end of the structure so members stay aligned in arrays of this structure
+    int max_alignment = 1;
+    for (std::shared_ptr<Branch> struct_branch_child : struct_body_branch->getChildren())
     {
         std::shared_ptr<VDEFBranch> vdef_child_branch = std::dynamic_pointer_cast<VDEFBranch>(struct_branch_child);
-        std::shared_ptr<VarIdentifierBranch> var_iden_child_branch = vdef_child_branch->getVariableIdentifierBranch();
-        int size = getDataTypeSizeFromVarDef(std::dynamic_pointer_cast<VDEFBranch>(vdef_child_branch));
-        // Check to see if we have an array going on here
-        if (var_iden_child_branch->hasRootArrayIndexBranch())
+        int alignment = getCodeGenerator()->getVariableAlignment(struct_body_branch, vdef_child_branch);
+        if (alignment > max_alignment)
         {
-            // We need to multiply all of the array indexes together so we know how many elements we have
-            std::shared_ptr<ArrayIndexBranch> array_index_branch = std::dynamic_pointer_cast<ArrayIndexBranch>(var_iden_child_branch->getRootArrayIndexBranch());
-            int total_array_indexes = getSumOfArrayIndexes(array_index_branch);
-            // Calculate the array size
-            size = total_array_indexes * size;
+            max_alignment = alignment;
         }
+    }
 
-        t_size += size;
+    if (t_size % max_alignment != 0)
+    {
+        t_size += max_alignment - (t_size % max_alignment);
     }
 
     return t_size;
@@ -142,7 +142,7 @@ bool DataTypeBranch::isPrimitive()
 void DataTypeBranch::imp_clone(std::shared_ptr<Branch> cloned_branch)
 {
     std::shared_ptr<DataTypeBranch> cloned_data_type_branch = std::dynamic_pointer_cast<DataTypeBranch>(cloned_branch);
-    if (cloned_data_type_branch->hasCustomDataTypeSize())
+    if (hasCustomDataTypeSize())
     {
         cloned_data_type_branch->setCustomDataTypeSize(this->custom_data_type_size);
     }
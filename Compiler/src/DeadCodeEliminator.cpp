@@ -0,0 +1,273 @@
+/*
+    Craft Compiler v0.1.0 - The standard compiler for the Craft programming language.
+    Copyright (C) 2016  Daniel McCarthy
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   DeadCodeEliminator.cpp
+ * Author: Daniel McCarthy
+ *
+ * Created on 18 October 2026, 16:40
+ *
+ * Description: Removes statements that can never run and the functions, declarations and global variables that nothing uses.
+ * 
+ * Every function that is not "__static" may be called from another file so it is always kept, as is the first function as that is where execution begins.
+ * Global variable initializers and inline assembly outside of functions are roots too as they are kept with whatever they reference.
+ * Anything those roots reference is kept and so on, references are found by name so a local variable with the same name as a global keeps the global.
+ */
+
+#include <map>
+#include <cctype>
+#include "DeadCodeEliminator.h"
+#include "branches.h"
+
+DeadCodeEliminator::DeadCodeEliminator(Compiler* compiler) : CompilerEntity(compiler)
+{
+    this->total_unreachable_statements = 0;
+}
+
+DeadCodeEliminator::~DeadCodeEliminator()
+{
+}
+
+void DeadCodeEliminator::setTree(std::shared_ptr<Tree> tree)
+{
+    this->tree = tree;
+}
+
+void DeadCodeEliminator::eliminate()
+{
+    this->total_unreachable_statements = 0;
+    this->report_messages.clear();
+
+    // Statements that can never run may be all that references something so they go first
+    std::map<std::string, std::shared_ptr<FuncBranch>> functions;
+    std::vector<std::shared_ptr<FuncBranch>> functions_to_scan;
+    std::set<std::string> root_names;
+    for (std::shared_ptr<Branch> child : this->tree->root->getChildren())
+    {
+        // Global variable initializers and inline assembly outside of functions are roots as well
+        if (child->getBranchType() == BRANCH_TYPE_VDEF)
+        {
+            std::shared_ptr<VDEFBranch> vdef_branch = std::dynamic_pointer_cast<VDEFBranch>(child);
+            if (vdef_branch->hasValueExpBranch())
+            {
+                find_referenced_names(vdef_branch->getValueExpBranch(), &root_names);
+            }
+        }
+        else if (child->getType() == "ASM")
+        {
+            find_referenced_names(child, &root_names);
+        }
+
+        if (child->getType() != "FUNC")
+            continue;
+
+        std::shared_ptr<FuncBranch> func_branch = std::dynamic_pointer_cast<FuncBranch>(child);
+        remove_unreachable_statements(func_branch->getBodyBranch());
+        functions[func_branch->getNameBranch()->getValue()] = func_branch;
+
+        // The first function is where execution begins so it is kept even if it is "__static"
+        if (!func_branch->isStatic() || functions_to_scan.empty())
+        {
+            functions_to_scan.push_back(func_branch);
+        }
+    }
+
+    std::set<std::string> reached_functions;
+    for (std::shared_ptr<FuncBranch> func_branch : functions_to_scan)
+    {
+        reached_functions.insert(func_branch->getNameBranch()->getValue());
+    }
+
+    std::set<std::string> referenced_names;
+    for (std::string name : root_names)
+    {
+        referenced_names.insert(name);
+        if (functions.find(name) != functions.end()
+                && reached_functions.find(name) == reached_functions.end())
+        {
+            reached_functions.insert(name);
+            functions_to_scan.push_back(functions[name]);
+        }
+    }
+
+    // Follow the references of every function we reach until there is nothing new to reach
+    while (!functions_to_scan.empty())
+    {
+        std::shared_ptr<FuncBranch> func_branch = functions_to_scan.back();
+        functions_to_scan.pop_back();
+
+        std::set<std::string> names;
+        find_referenced_names(func_branch->getBodyBranch(), &names);
+        for (std::string name : names)
+        {
+            referenced_names.insert(name);
+            if (functions.find(name) != functions.end()
+                    && reached_functions.find(name) == reached_functions.end())
+            {
+                reached_functions.insert(name);
+                functions_to_scan.push_back(functions[name]);
+            }
+        }
+    }
+
+    remove_unreferenced_global_branches(reached_functions, referenced_names);
+
+    this->report_messages.push_back("Unreachable statements removed: " + std::to_string(this->total_unreachable_statements));
+}
+
+std::vector<std::string> DeadCodeEliminator::getReport()
+{
+    return this->report_messages;
+}
+
+void DeadCodeEliminator::remove_unreachable_statements(std::shared_ptr<Branch> branch)
+{
+    if (branch->getType() == "BODY")
+    {
+        bool unreachable = false;
+        for (std::shared_ptr<Branch> child : branch->getChildren())
+        {
+            std::string type = child->getType();
+            if (type == "CASE" || type == "DEFAULT")
+            {
+                // A switch statement can jump here
+                unreachable = false;
+            }
+            else if (unreachable && child->getBranchType() != BRANCH_TYPE_VDEF)
+            {
+                /* Variable definitions are left as they are part of the scope,
+                 * a switch statement could jump to a case below that uses them */
+                child->removeSelf();
+                this->total_unreachable_statements++;
+                continue;
+            }
+
+            if (type == "RETURN" || type == "BREAK" || type == "CONTINUE")
+            {
+                unreachable = true;
+            }
+        }
+    }
+
+    for (std::shared_ptr<Branch> child : branch->getChildren())
+    {
+        remove_unreachable_statements(child);
+    }
+}
+
+void DeadCodeEliminator::find_referenced_names(std::shared_ptr<Branch> branch, std::set<std::string>* names)
+{
+    std::string type = branch->getType();
+    if (type == "FUNC_CALL")
+    {
+        names->insert(std::dynamic_pointer_cast<FuncCallBranch>(branch)->getFuncNameBranch()->getValue());
+    }
+    else if (type == "VAR_IDENTIFIER")
+    {
+        names->insert(std::dynamic_pointer_cast<VarIdentifierBranch>(branch)->getVariableNameBranch()->getValue());
+    }
+    else if (type == "ASM")
+    {
+        find_asm_referenced_names(std::dynamic_pointer_cast<ASMBranch>(branch), names);
+    }
+
+    for (std::shared_ptr<Branch> child : branch->getChildren())
+    {
+        find_referenced_names(child, names);
+    }
+}
+
+void DeadCodeEliminator::find_asm_referenced_names(std::shared_ptr<ASMBranch> asm_branch, std::set<std::string>* names)
+{
+    // Inline assembly may refer to labels of functions directly e.g "call _print"
+    std::string asm_str = asm_branch->getInstructionStartStringBranch()->getValue();
+    for (std::shared_ptr<Branch> child : asm_branch->getInstructionArgumentsBranch()->getChildren())
+    {
+        asm_str += " " + std::dynamic_pointer_cast<ASMArgBranch>(child)->getNextStringBranch()->getValue();
+    }
+
+    std::string word = "";
+    for (unsigned int i = 0; i <= asm_str.length(); i++)
+    {
+        char c = (i < asm_str.length() ? asm_str[i] : ' ');
+        if (isalnum(c) || c == '_')
+        {
+            word += c;
+            continue;
+        }
+
+        if (word.length() > 1 && word[0] == '_')
+        {
+            // Labels are the name with an underscore before it
+            names->insert(word.substr(1));
+        }
+        word = "";
+    }
+}
+
+void DeadCodeEliminator::remove_unreferenced_global_branches(std::set<std::string>& reached_functions, std::set<std::string>& referenced_names)
+{
+    std::vector<std::shared_ptr<Branch>> branches_to_remove;
+    for (std::shared_ptr<Branch> child : this->tree->root->getChildren())
+    {
+        std::string name = get_global_branch_name(child);
+        if (child->getType() == "FUNC")
+        {
+            if (reached_functions.find(name) == reached_functions.end())
+            {
+                branches_to_remove.push_back(child);
+                this->report_messages.push_back("Removed unreferenced function: " + name);
+            }
+        }
+        else if (child->getType() == "FUNC_DEF")
+        {
+            // Declarations of functions that are never called would otherwise still need to be linked with
+            if (referenced_names.find(name) == referenced_names.end())
+            {
+                branches_to_remove.push_back(child);
+                this->report_messages.push_back("Removed unreferenced function declaration: " + name);
+            }
+        }
+        else if (child->getBranchType() == BRANCH_TYPE_VDEF)
+        {
+            if (referenced_names.find(name) == referenced_names.end())
+            {
+                branches_to_remove.push_back(child);
+                this->report_messages.push_back("Removed unreferenced global variable: " + name);
+            }
+        }
+    }
+
+    for (std::shared_ptr<Branch> branch : branches_to_remove)
+    {
+        branch->removeSelf();
+    }
+}
+
+std::string DeadCodeEliminator::get_global_branch_name(std::shared_ptr<Branch> branch)
+{
+    if (branch->getType() == "FUNC" || branch->getType() == "FUNC_DEF")
+    {
+        return std::dynamic_pointer_cast<FuncDefBranch>(branch)->getNameBranch()->getValue();
+    }
+    else if (branch->getBranchType() == BRANCH_TYPE_VDEF)
+    {
+        return std::dynamic_pointer_cast<VDEFBranch>(branch)->getVariableIdentifierBranch()->getVariableNameBranch()->getValue();
+    }
+
+    return "";
+}
@@ -0,0 +1,45 @@
+/*
+    Craft compiler v0.1.0 - The standard compiler for the Craft programming language.
+    Copyright (C) 2016  Daniel McCarthy
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* 
+ * File:   DefaultBranch.cpp
+ * Author: Daniel McCarthy
+ *
+ * Created on 18 October 2026, 14:20
+ * 
+ * Description: Marks where a switch statement jumps to when none of its cases match.
+ */
+
+#include "DefaultBranch.h"
+
+DefaultBranch::DefaultBranch(Compiler* compiler) : CustomBranch(compiler, "DEFAULT", "")
+{
+}
+
+DefaultBranch::~DefaultBranch()
+{
+}
+
+void DefaultBranch::imp_clone(std::shared_ptr<Branch> cloned_branch)
+{
+
+}
+
+std::shared_ptr<Branch> DefaultBranch::create_clone()
+{
+    return std::shared_ptr<Branch>(new DefaultBranch(getCompiler()));
+}
\ No newline at end of file
@@ -30,11 +30,16 @@
 
 FuncDefBranch::FuncDefBranch(Compiler* compiler) : CustomBranch(compiler, "FUNC_DEF", "")
 {
+    this->calling_convention = "";
+    this->no_inline = false;
+    this->is_static = false;
 }
 
 FuncDefBranch::FuncDefBranch(Compiler* compiler, std::string type, std::string value) : CustomBranch(compiler, type, value)
 {
-
+    this->calling_convention = "";
+    this->no_inline = false;
+    this->is_static = false;
 }
 
 FuncDefBranch::~FuncDefBranch()
@@ -56,6 +61,21 @@ void FuncDefBranch::setArgumentsBranch(std::shared_ptr<FuncArgumentsBranch> argu
     this->registerBranch("func_arguments_branch", argumentsBranch);
 }
 
+void FuncDefBranch::setCallingConvention(std::string calling_convention)
+{
+    this->calling_convention = calling_convention;
+}
+
+void FuncDefBranch::setNoInline(bool no_inline)
+{
+    this->no_inline = no_inline;
+}
+
+void FuncDefBranch::setStatic(bool is_static)
+{
+    this->is_static = is_static;
+}
+
 std::shared_ptr<DataTypeBranch> FuncDefBranch::getReturnDataTypeBranch()
 {
     return std::dynamic_pointer_cast<DataTypeBranch>(CustomBranch::getRegisteredBranchByName("func_return_data_type_branch"));
@@ -71,6 +91,32 @@ std::shared_ptr<FuncArgumentsBranch> FuncDefBranch::getArgumentsBranch()
     return std::dynamic_pointer_cast<FuncArgumentsBranch>(this->getRegisteredBranchByName("func_arguments_branch"));
 }
 
+std::string FuncDefBranch::getCallingConvention()
+{
+    return this->calling_convention;
+}
+
+bool FuncDefBranch::isRegisterCall()
+{
+    if (this->calling_convention == "__regcall")
+        return true;
+    if (this->calling_convention == "__stackcall")
+        return false;
+
+    // No attribute was given so the module wide default applies
+    return getCompiler()->hasArgument("regcall");
+}
+
+bool FuncDefBranch::isNoInline()
+{
+    return this->no_inline;
+}
+
+bool FuncDefBranch::isStatic()
+{
+    return this->is_static;
+}
+
 bool FuncDefBranch::isOnlyDefinition()
 {
     return true;
@@ -82,6 +128,9 @@ void FuncDefBranch::imp_clone(std::shared_ptr<Branch> cloned_branch)
     func_branch_cloned->setReturnDataTypeBranch(std::dynamic_pointer_cast<DataTypeBranch>(getReturnDataTypeBranch()->clone()));
     func_branch_cloned->setNameBranch(getNameBranch()->clone());
     func_branch_cloned->setArgumentsBranch(std::dynamic_pointer_cast<FuncArgumentsBranch>(getArgumentsBranch()->clone()));
+    func_branch_cloned->setCallingConvention(getCallingConvention());
+    func_branch_cloned->setNoInline(isNoInline());
+    func_branch_cloned->setStatic(isStatic());
 }
 
 std::shared_ptr<Branch> FuncDefBranch::create_clone()
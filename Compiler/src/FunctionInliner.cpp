@@ -0,0 +1,462 @@
+/*
+    Craft Compiler v0.1.0 - The standard compiler for the Craft programming language.
+    Copyright (C) 2016  Daniel McCarthy
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   FunctionInliner.cpp
+ * Author: Daniel McCarthy
+ *
+ * Created on 18 October 2026, 10:12
+ *
+ * Description: Replaces calls to small functions and functions that are only called once with the body of the function.
+ * This runs on the validated tree so the code generator never knows a call was ever there.
+ * Only functions whose bodies are straight line code or "if" statements with a single return at the end are inlined
+ * as the body is spliced directly into the body of the caller.
+ */
+
+#include "FunctionInliner.h"
+#include "branches.h"
+
+FunctionInliner::FunctionInliner(Compiler* compiler) : CompilerEntity(compiler)
+{
+    this->total_inlined_calls = 0;
+}
+
+FunctionInliner::~FunctionInliner()
+{
+}
+
+void FunctionInliner::setTree(std::shared_ptr<Tree> tree)
+{
+    this->tree = tree;
+}
+
+void FunctionInliner::inline_functions()
+{
+    this->call_sites.clear();
+    count_call_sites(this->tree->root);
+
+    for (std::shared_ptr<Branch> child : this->tree->root->getChildren())
+    {
+        if (child->getType() != "FUNC")
+            continue;
+
+        std::shared_ptr<FuncBranch> func_branch = std::dynamic_pointer_cast<FuncBranch>(child);
+
+        /* We find all the calls before we inline any of them so that the calls inside a body we have just inlined
+         * are not inlined again, otherwise functions that call each other would be inlined forever */
+        std::vector<std::shared_ptr<Branch>> stmt_branches;
+        find_call_statements(func_branch->getBodyBranch(), &stmt_branches);
+        for (std::shared_ptr<Branch> stmt_branch : stmt_branches)
+        {
+            std::shared_ptr<FuncCallBranch> func_call_branch = get_inlinable_call(stmt_branch);
+            if (func_call_branch != NULL)
+            {
+                inline_call(func_branch, stmt_branch, func_call_branch);
+            }
+        }
+    }
+}
+
+int FunctionInliner::getTotalInlinedCalls()
+{
+    return this->total_inlined_calls;
+}
+
+void FunctionInliner::find_call_statements(std::shared_ptr<Branch> branch, std::vector<std::shared_ptr<Branch>>* stmt_branches)
+{
+    for (std::shared_ptr<Branch> child : branch->getChildren())
+    {
+        if (branch->getType() == "BODY"
+                && get_inlinable_call(child) != NULL)
+        {
+            stmt_branches->push_back(child);
+        }
+        else
+        {
+            find_call_statements(child, stmt_branches);
+        }
+    }
+}
+
+std::shared_ptr<FuncCallBranch> FunctionInliner::get_inlinable_call(std::shared_ptr<Branch> stmt_branch)
+{
+    /* Only calls that are a statement on their own, the value of an assignment or variable definition
+     * or the expression of a return can be inlined. e.g "a = add(b, c);" */
+    std::shared_ptr<Branch> call_branch = NULL;
+    std::string type = stmt_branch->getType();
+    if (type == "FUNC_CALL")
+    {
+        call_branch = stmt_branch;
+    }
+    else if (type == "ASSIGN")
+    {
+        call_branch = std::dynamic_pointer_cast<AssignBranch>(stmt_branch)->getValueBranch();
+    }
+    else if (type == "V_DEF")
+    {
+        std::shared_ptr<VDEFBranch> vdef_branch = std::dynamic_pointer_cast<VDEFBranch>(stmt_branch);
+        if (vdef_branch->hasValueExpBranch())
+        {
+            call_branch = vdef_branch->getValueExpBranch();
+        }
+    }
+    else if (type == "RETURN")
+    {
+        std::shared_ptr<ReturnBranch> return_branch = std::dynamic_pointer_cast<ReturnBranch>(stmt_branch);
+        if (return_branch->hasExpressionBranch())
+        {
+            call_branch = return_branch->getExpressionBranch();
+        }
+    }
+
+    if (call_branch == NULL || call_branch->getType() != "FUNC_CALL")
+        return NULL;
+
+    return std::dynamic_pointer_cast<FuncCallBranch>(call_branch);
+}
+
+bool FunctionInliner::inline_call(std::shared_ptr<FuncBranch> caller_func_branch, std::shared_ptr<Branch> stmt_branch, std::shared_ptr<FuncCallBranch> func_call_branch)
+{
+    std::string func_name = func_call_branch->getFuncNameBranch()->getValue();
+    if (func_name == caller_func_branch->getNameBranch()->getValue())
+        return false;
+
+    std::shared_ptr<FuncBranch> func_branch = get_inlinable_function(func_name);
+    if (func_branch == NULL)
+        return false;
+
+    std::shared_ptr<FuncArgumentsBranch> func_args_branch = func_branch->getArgumentsBranch();
+    std::shared_ptr<BODYBranch> func_body_branch = func_branch->getBodyBranch();
+    std::vector<std::shared_ptr<Branch>> args = func_args_branch->getChildren();
+    std::vector<std::shared_ptr<Branch>> params = func_call_branch->getFuncParamsBranch()->getChildren();
+    if (args.size() != params.size())
+        return false;
+
+    std::vector<std::shared_ptr<Branch>> stmts = func_body_branch->getChildren();
+    std::shared_ptr<ReturnBranch> return_branch = NULL;
+    if (!stmts.empty() && stmts.back()->getType() == "RETURN")
+    {
+        return_branch = std::dynamic_pointer_cast<ReturnBranch>(stmts.back());
+        stmts.pop_back();
+    }
+
+    std::shared_ptr<Branch> return_exp_branch = NULL;
+    if (return_branch != NULL && return_branch->hasExpressionBranch())
+    {
+        return_exp_branch = return_branch->getExpressionBranch();
+    }
+
+    // Only a call that is a statement on its own can do without the returned value
+    if (stmt_branch != func_call_branch && return_exp_branch == NULL)
+        return false;
+
+    // A returned value that is thrown away can only be dropped if evaluating it does nothing
+    if (stmt_branch == func_call_branch && return_exp_branch != NULL
+            && return_exp_branch->getType() != "FUNC_CALL" && has_side_effects(return_exp_branch))
+        return false;
+
+    // The arguments and local variables of the function are renamed so they cannot clash with the callers variables
+    std::map<std::string, std::string> new_names;
+    std::string prefix = "__inline" + std::to_string(this->total_inlined_calls) + "_";
+    for (std::shared_ptr<Branch> arg : args)
+    {
+        std::string name = std::dynamic_pointer_cast<VDEFBranch>(arg)->getVariableIdentifierBranch()->getVariableNameBranch()->getValue();
+        new_names[name] = prefix + name;
+    }
+
+    std::set<std::string> local_names;
+    get_declared_names(func_body_branch, &local_names);
+    for (std::string name : local_names)
+    {
+        new_names[name] = prefix + name;
+    }
+
+    /* Any other variable the function uses is a global variable, if the caller has a variable of the same name
+     * then the inlined body would end up using the callers variable rather than the global one */
+    std::set<std::string> used_names;
+    get_var_names(func_body_branch, &used_names);
+    std::set<std::string> caller_names;
+    get_declared_names(caller_func_branch->getArgumentsBranch(), &caller_names);
+    get_declared_names(caller_func_branch->getBodyBranch(), &caller_names);
+    for (std::string name : used_names)
+    {
+        if (new_names.find(name) == new_names.end()
+                && caller_names.find(name) != caller_names.end())
+            return false;
+    }
+
+    std::shared_ptr<Branch> caller_body_branch = stmt_branch->getParent();
+    std::shared_ptr<ScopeBranch> new_scope = std::dynamic_pointer_cast<ScopeBranch>(caller_body_branch);
+    std::shared_ptr<ScopeBranch> new_root_scope = stmt_branch->getRootScope();
+    // Key = scope of the function, value = the scope its clone belongs to
+    std::map<std::shared_ptr<ScopeBranch>, std::shared_ptr<ScopeBranch>> new_scopes;
+    new_scopes[func_body_branch] = new_scope;
+    new_scopes[func_args_branch] = new_scope;
+
+    // The arguments become variables of the caller that are assigned the parameters of the call
+    for (size_t i = 0; i < args.size(); i++)
+    {
+        std::shared_ptr<VDEFBranch> vdef_branch = std::dynamic_pointer_cast<VDEFBranch>(args[i]->clone());
+        rename_vars(vdef_branch, new_names);
+        move_scopes(vdef_branch, new_scopes, func_body_branch, func_args_branch, new_root_scope);
+        vdef_branch->setVariableType(VARIABLE_TYPE_FUNCTION_VARIABLE);
+        vdef_branch->setValueExpBranch(params[i]->clone());
+        caller_body_branch->addChild(vdef_branch, stmt_branch);
+    }
+
+    for (std::shared_ptr<Branch> stmt : stmts)
+    {
+        std::shared_ptr<Branch> stmt_clone = stmt->clone();
+        rename_vars(stmt_clone, new_names);
+        move_scopes(stmt_clone, new_scopes, func_body_branch, func_args_branch, new_root_scope);
+        caller_body_branch->addChild(stmt_clone, stmt_branch);
+    }
+
+    std::shared_ptr<Branch> return_exp_clone = NULL;
+    if (return_exp_branch != NULL)
+    {
+        return_exp_clone = return_exp_branch->clone();
+        rename_vars(return_exp_clone, new_names);
+        move_scopes(return_exp_clone, new_scopes, func_body_branch, func_args_branch, new_root_scope);
+    }
+
+    if (stmt_branch == func_call_branch
+            && (return_exp_clone == NULL || return_exp_clone->getType() != "FUNC_CALL"))
+    {
+        // The returned value is not used so the call can go entirely
+        stmt_branch->removeSelf();
+    }
+    else
+    {
+        func_call_branch->replaceSelf(return_exp_clone);
+    }
+
+    this->total_inlined_calls++;
+    return true;
+}
+
+std::shared_ptr<FuncBranch> FunctionInliner::get_inlinable_function(std::string func_name)
+{
+    std::shared_ptr<FuncBranch> func_branch = NULL;
+    for (std::shared_ptr<Branch> child : this->tree->root->getChildren())
+    {
+        if (child->getType() != "FUNC" && child->getType() != "FUNC_DEF")
+            continue;
+
+        std::shared_ptr<FuncDefBranch> func_def_branch = std::dynamic_pointer_cast<FuncDefBranch>(child);
+        if (func_def_branch->getNameBranch()->getValue() != func_name)
+            continue;
+
+        // "__noinline" may be given on either the declaration or the function itself
+        if (func_def_branch->isNoInline())
+            return NULL;
+
+        if (child->getType() == "FUNC")
+        {
+            func_branch = std::dynamic_pointer_cast<FuncBranch>(child);
+        }
+    }
+
+    // Functions only declared in this module have no body for us to inline
+    if (func_branch == NULL)
+        return NULL;
+
+    for (std::shared_ptr<Branch> arg : func_branch->getArgumentsBranch()->getChildren())
+    {
+        if (arg->getType() != "V_DEF"
+                || std::dynamic_pointer_cast<VDEFBranch>(arg)->getVariableIdentifierBranch()->hasRootArrayIndexBranch())
+            return NULL;
+    }
+
+    if (!is_inlinable_body(func_branch->getBodyBranch()))
+        return NULL;
+
+    // Functions called only once are always inlined as there is no copy of the body left to pay for
+    if (this->call_sites[func_name] != 1
+            && count_branches(func_branch) > getMaxFunctionBranches())
+        return NULL;
+
+    return func_branch;
+}
+
+bool FunctionInliner::is_inlinable_body(std::shared_ptr<Branch> body_branch, bool is_function_body)
+{
+    /* The body may only return as its last statement, "if" statements are allowed as long as their bodies
+     * follow the same rules without returning at all */
+    std::vector<std::shared_ptr<Branch>> children = body_branch->getChildren();
+    for (size_t i = 0; i < children.size(); i++)
+    {
+        std::string type = children[i]->getType();
+        if (type == "RETURN" && is_function_body && i + 1 == children.size())
+            continue;
+
+        if (type == "IF")
+        {
+            if (!is_inlinable_if(std::dynamic_pointer_cast<IFBranch>(children[i])))
+                return false;
+            continue;
+        }
+
+        if (type != "V_DEF" && type != "ASSIGN" && type != "FUNC_CALL")
+            return false;
+    }
+
+    return true;
+}
+
+bool FunctionInliner::is_inlinable_if(std::shared_ptr<IFBranch> if_branch)
+{
+    if (!is_inlinable_body(if_branch->getBodyBranch(), false))
+        return false;
+
+    if (if_branch->hasElseIfBranch())
+        return is_inlinable_if(if_branch->getElseIfBranch());
+
+    if (if_branch->hasElseBranch())
+        return is_inlinable_body(if_branch->getElseBranch()->getBodyBranch(), false);
+
+    return true;
+}
+
+bool FunctionInliner::has_side_effects(std::shared_ptr<Branch> branch)
+{
+    if (branch->getType() == "FUNC_CALL" || branch->getType() == "ASSIGN")
+        return true;
+
+    for (std::shared_ptr<Branch> child : branch->getChildren())
+    {
+        if (has_side_effects(child))
+            return true;
+    }
+
+    return false;
+}
+
+int FunctionInliner::count_branches(std::shared_ptr<Branch> branch)
+{
+    int total = 1;
+    for (std::shared_ptr<Branch> child : branch->getChildren())
+    {
+        total += count_branches(child);
+    }
+    return total;
+}
+
+void FunctionInliner::count_call_sites(std::shared_ptr<Branch> branch)
+{
+    if (branch->getType() == "FUNC_CALL")
+    {
+        std::shared_ptr<FuncCallBranch> func_call_branch = std::dynamic_pointer_cast<FuncCallBranch>(branch);
+        this->call_sites[func_call_branch->getFuncNameBranch()->getValue()]++;
+    }
+
+    for (std::shared_ptr<Branch> child : branch->getChildren())
+    {
+        count_call_sites(child);
+    }
+}
+
+void FunctionInliner::get_declared_names(std::shared_ptr<Branch> branch, std::set<std::string>* names)
+{
+    if (branch->getBranchType() == BRANCH_TYPE_VDEF)
+    {
+        std::shared_ptr<VDEFBranch> vdef_branch = std::dynamic_pointer_cast<VDEFBranch>(branch);
+        names->insert(vdef_branch->getVariableIdentifierBranch()->getVariableNameBranch()->getValue());
+    }
+
+    for (std::shared_ptr<Branch> child : branch->getChildren())
+    {
+        get_declared_names(child, names);
+    }
+}
+
+void FunctionInliner::get_var_names(std::shared_ptr<Branch> branch, std::set<std::string>* names, bool is_struct_member)
+{
+    if (branch->getType() == "VAR_IDENTIFIER" && !is_struct_member)
+    {
+        std::shared_ptr<VarIdentifierBranch> var_iden_branch = std::dynamic_pointer_cast<VarIdentifierBranch>(branch);
+        names->insert(var_iden_branch->getVariableNameBranch()->getValue());
+    }
+
+    for (std::shared_ptr<Branch> child : branch->getChildren())
+    {
+        // The variable identifier of a structure access names a member of the structure rather than a variable
+        get_var_names(child, names, branch->getType() == "STRUCT_ACCESS" && child->getType() == "VAR_IDENTIFIER");
+    }
+}
+
+void FunctionInliner::rename_vars(std::shared_ptr<Branch> branch, std::map<std::string, std::string>& new_names, bool is_struct_member)
+{
+    if (branch->getType() == "VAR_IDENTIFIER" && !is_struct_member)
+    {
+        std::shared_ptr<Branch> name_branch = std::dynamic_pointer_cast<VarIdentifierBranch>(branch)->getVariableNameBranch();
+        if (new_names.find(name_branch->getValue()) != new_names.end())
+        {
+            name_branch->setValue(new_names[name_branch->getValue()]);
+        }
+    }
+
+    for (std::shared_ptr<Branch> child : branch->getChildren())
+    {
+        rename_vars(child, new_names, branch->getType() == "STRUCT_ACCESS" && child->getType() == "VAR_IDENTIFIER");
+    }
+}
+
+void FunctionInliner::move_scopes(std::shared_ptr<Branch> branch, std::map<std::shared_ptr<ScopeBranch>, std::shared_ptr<ScopeBranch>>& new_scopes, std::shared_ptr<ScopeBranch> old_scope, std::shared_ptr<ScopeBranch> old_args_scope, std::shared_ptr<ScopeBranch> new_root_scope)
+{
+    /* Cloned branches still point to the scopes of the function they were cloned from.
+     * Scopes of structures are left alone as the structure access still needs them */
+    if (new_scopes.find(branch->getLocalScope()) != new_scopes.end())
+    {
+        branch->setLocalScope(new_scopes[branch->getLocalScope()]);
+    }
+
+    if (branch->getRootScope() == old_scope || branch->getRootScope() == old_args_scope)
+    {
+        branch->setRootScope(new_root_scope);
+    }
+
+    /* The statements of a cloned body such as the body of an "if" statement still point to the body they were cloned from,
+     * so from now on that body is replaced by its clone */
+    if (branch->getType() == "BODY")
+    {
+        std::shared_ptr<ScopeBranch> scope_branch = std::dynamic_pointer_cast<ScopeBranch>(branch);
+        for (std::shared_ptr<Branch> child : branch->getChildren())
+        {
+            if (child->hasLocalScope() && child->getLocalScope() != scope_branch
+                    && new_scopes.find(child->getLocalScope()) == new_scopes.end())
+            {
+                new_scopes[child->getLocalScope()] = scope_branch;
+            }
+        }
+    }
+
+    for (std::shared_ptr<Branch> child : branch->getChildren())
+    {
+        move_scopes(child, new_scopes, old_scope, old_args_scope, new_root_scope);
+    }
+}
+
+int FunctionInliner::getMaxFunctionBranches()
+{
+    if (getCompiler()->hasArgument("Os"))
+    {
+        return INLINE_MAX_FUNCTION_BRANCHES_FOR_SIZE;
+    }
+
+    return INLINE_MAX_FUNCTION_BRANCHES;
+}
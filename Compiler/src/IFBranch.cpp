@@ -99,9 +99,18 @@ bool IFBranch::hasElseIfBranch()
 void IFBranch::imp_clone(std::shared_ptr<Branch> cloned_branch)
 {
     std::shared_ptr<IFBranch> if_branch_clone = std::dynamic_pointer_cast<IFBranch>(cloned_branch);
+    if_branch_clone->setExpressionBranch(getExpressionBranch()->clone());
     if_branch_clone->setBodyBranch(std::dynamic_pointer_cast<BODYBranch>(getBodyBranch()->clone()));
-    if_branch_clone->setElseBranch(std::dynamic_pointer_cast<ELSEBranch>(getElseBranch()->clone()));
-    if_branch_clone->setElseIfBranch(std::dynamic_pointer_cast<IFBranch>(getElseIfBranch()->clone()));
+    // Else and else if branches are optional
+    if (hasElseBranch())
+    {
+        if_branch_clone->setElseBranch(std::dynamic_pointer_cast<ELSEBranch>(getElseBranch()->clone()));
+    }
+
+    if (hasElseIfBranch())
+    {
+        if_branch_clone->setElseIfBranch(std::dynamic_pointer_cast<IFBranch>(getElseIfBranch()->clone()));
+    }
 }
 
 std::shared_ptr<Branch> IFBranch::create_clone()
@@ -29,9 +29,10 @@
 #include "Compiler.h"
 
 const char operators[] = {'=', '+', '-', '/', '*', '<', '>', '&', '|', '^', '%', '!'};
-const char symbols[] = {'(', ')', ',', '#', '{', '}', '.', '[', ']', ';'};
+const char symbols[] = {'(', ')', ',', '#', '{', '}', '.', '[', ']', ';', ':'};
 const std::string general_keywords[] = {
-    "if", "for", "do", "while", "continue", "break", "switch", "__asm", "else", "return", "include", "ifdef", "ifndef", "define"
+    "if", "for", "do", "while", "continue", "break", "switch", "case", "default", "__asm", "else", "return", "include", "ifdef", "ifndef", "define",
+    "__regcall", "__stackcall", "__noinline", "__static"
 };
 
 const std::string data_type_keywords[] = {
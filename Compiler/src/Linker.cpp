@@ -24,9 +24,12 @@
  * Description: The base linker class for all linkers
  */
 
+#include <algorithm>
 #include "Linker.h"
 #include "Stream.h"
 #include "VirtualObjectFormat.h"
+#include "Archive.h"
+#include "Compiler.h"
 #include "common.h"
 
 Linker::Linker(Compiler* compiler) : CompilerEntity(compiler)
@@ -52,6 +55,16 @@ bool Linker::hasObjectFile(std::shared_ptr<VirtualObjectFormat> obj)
     return std::find(this->obj_stack.begin(), this->obj_stack.end(), obj) != this->obj_stack.end();
 }
 
+void Linker::addArchive(std::shared_ptr<Archive> archive)
+{
+    this->archives.push_back(archive);
+}
+
+void Linker::setObjectFormatFactory(ObjectFormatFactory object_format_factory)
+{
+    this->object_format_factory = object_format_factory;
+}
+
 void Linker::link()
 {
     if (this->obj_stack.empty())
@@ -67,6 +80,11 @@ void Linker::link()
         this->link_merge(main_obj, other_obj);
     }
 
+    // Archive members are only linked in when they define something we still need
+    if (!this->archives.empty())
+    {
+        pull_archive_members(main_obj);
+    }
 
     /* At this point we should have all external references defined in one object file, 
      * so lets make sure external references can be linked up properly */
@@ -79,6 +97,12 @@ void Linker::link()
         }
     }
 
+    // Function sections that nothing can reach are removed before anything is given a position
+    if (!getCompiler()->hasArgument("no_gc_sections"))
+    {
+        collect_garbage(main_obj);
+    }
+
     // Resolve unknown symbols
     this->resolve(main_obj);
 
@@ -90,52 +114,27 @@ void Linker::link()
     // Ok we may need to apply an origin for each segment now
     for (std::shared_ptr<VirtualSegment> segment : main_obj->getSegments())
     {
-        for (std::shared_ptr<FIXUP> fixup : segment->getFixups())
+        // Segments appended from other object files hold their own fixups and bytes
+        for (std::shared_ptr<VirtualSegment> part : segment->getParts())
         {
-            if (fixup->getType() == FIXUP_TYPE_SEGMENT)
+            char* buf = part->getStream()->getBuf();
+            for (std::shared_ptr<FIXUP> fixup : get_sorted_fixups(part))
             {
-                if (fixup->getTarget()->getType() == FIXUP_TARGET_TYPE_SEGMENT)
+                if (fixup->getType() == FIXUP_TYPE_SEGMENT)
                 {
-                    std::shared_ptr<FIXUP_TARGET_SEGMENT> fixup_target_segment = std::dynamic_pointer_cast<FIXUP_TARGET_SEGMENT>(fixup->getTarget());
-                    if (fixup_target_segment->getTargetSegment()->hasOrigin())
+                    if (fixup->getTarget()->getType() == FIXUP_TARGET_TYPE_SEGMENT)
                     {
-                        int origin = fixup_target_segment->getTargetSegment()->getOrigin();
-                        int fixup_old_value;
-                        int fixup_new_value;
-                        switch (fixup->getLength())
-                        {
-                        case FIXUP_8BIT:
-                            fixup_old_value = segment->getStream()->peek8(fixup->getOffset());
-                            break;
-                        case FIXUP_16BIT:
-                            fixup_old_value = segment->getStream()->peek16(fixup->getOffset());
-                            break;
-                        case FIXUP_32BIT:
-                            fixup_old_value = segment->getStream()->peek32(fixup->getOffset());
-                            break;
-                        }
-
-
-                        fixup_new_value = fixup_old_value + origin;
-
-                        // Now finally lets overwrite it with the new value
-                        switch (fixup->getLength())
+                        std::shared_ptr<FIXUP_TARGET_SEGMENT> fixup_target_segment = std::dynamic_pointer_cast<FIXUP_TARGET_SEGMENT>(fixup->getTarget());
+                        if (fixup_target_segment->getTargetSegment()->hasOrigin())
                         {
-                        case FIXUP_8BIT:
-                            segment->getStream()->overwrite8(fixup->getOffset(), fixup_new_value);
-                            break;
-                        case FIXUP_16BIT:
-                            segment->getStream()->overwrite16(fixup->getOffset(), fixup_new_value);
-                            break;
-                        case FIXUP_32BIT:
-                            segment->getStream()->overwrite32(fixup->getOffset(), fixup_new_value);
-                            break;
+                            int origin = fixup_target_segment->getTargetSegment()->getOrigin();
+                            apply_fixup(part, buf, fixup, read_fixup(part, buf, fixup) + origin);
                         }
                     }
-                }
-                else
-                {
-                    // May need to apply origin for external fixups here, really depends not implementing it yet 
+                    else
+                    {
+                        // May need to apply origin for external fixups here, really depends not implementing it yet 
+                    }
                 }
             }
         }
@@ -150,6 +149,198 @@ void Linker::link()
 
 }
 
+void Linker::pull_archive_members(std::shared_ptr<VirtualObjectFormat> final_obj)
+{
+    if (this->object_format_factory == NULL)
+    {
+        throw Exception("Archives were provided but no object format factory was set to read their members with", "void Linker::pull_archive_members(std::shared_ptr<VirtualObjectFormat> final_obj)");
+    }
+
+    // Key = archive, value = the indexes of its members that have been linked in
+    std::map<std::shared_ptr<Archive>, std::set<int>> pulled_members;
+    // Members we pull in may have external references of their own so we keep going until nothing new is pulled in
+    bool pulled_member = true;
+    while (pulled_member)
+    {
+        pulled_member = false;
+        for (std::string ext_ref : final_obj->getExternalReferences())
+        {
+            if (final_obj->hasGlobalReference(ext_ref))
+            {
+                continue;
+            }
+
+            // The first archive that defines the reference is the one used
+            for (std::shared_ptr<Archive> archive : this->archives)
+            {
+                int index = archive->getMemberIndexForSymbol(ext_ref);
+                if (index == -1 || pulled_members[archive].find(index) != pulled_members[archive].end())
+                {
+                    continue;
+                }
+
+                struct ARCHIVE_MEMBER member = archive->getMember(index);
+                std::shared_ptr<VirtualObjectFormat> member_obj = this->object_format_factory(member.format_name);
+                try
+                {
+                    member_obj->read(archive->getMemberStream(index));
+                }
+                catch (Exception ex)
+                {
+                    throw Exception("Failed to read the archive member: " + member.name + ", " + ex.getMessage(), "void Linker::pull_archive_members(std::shared_ptr<VirtualObjectFormat> final_obj)");
+                }
+
+                this->link_merge(final_obj, member_obj);
+                pulled_members[archive].insert(index);
+                pulled_member = true;
+                report("Pulled in " + member.name + " from an archive to define " + ext_ref);
+                break;
+            }
+        }
+    }
+}
+
+void Linker::collect_garbage(std::shared_ptr<VirtualObjectFormat> final_obj)
+{
+    // Mark everything reachable from the root segments, the code segment is among them as execution begins there
+    std::set<std::shared_ptr<VirtualSegment>> marked_segments;
+    for (std::shared_ptr<VirtualSegment> segment : final_obj->getSegments())
+    {
+        if (is_root_segment(segment))
+        {
+            mark_segment(final_obj, segment, &marked_segments);
+        }
+    }
+
+    // Sweep away the rest, nothing that is left can refer to them
+    for (std::shared_ptr<VirtualSegment> segment : final_obj->getSegments())
+    {
+        if (marked_segments.find(segment) == marked_segments.end())
+        {
+            final_obj->removeSegment(segment);
+            report("Removed unreferenced segment: " + segment->getName() + " (" + std::to_string(segment->getSize()) + " bytes)");
+        }
+    }
+}
+
+void Linker::mark_segment(std::shared_ptr<VirtualObjectFormat> final_obj, std::shared_ptr<VirtualSegment> segment, std::set<std::shared_ptr<VirtualSegment>>* marked_segments)
+{
+    if (marked_segments->find(segment) != marked_segments->end())
+    {
+        return;
+    }
+    marked_segments->insert(segment);
+
+    for (std::shared_ptr<VirtualSegment> part : segment->getParts())
+    {
+        for (std::shared_ptr<FIXUP> fixup : part->getFixups())
+        {
+            std::shared_ptr<FIXUP_TARGET> target = fixup->getTarget();
+            if (target->getType() == FIXUP_TARGET_TYPE_SEGMENT)
+            {
+                // Merged fixups still point to the segment of the object they came from so we go by name
+                std::string target_segment_name = std::dynamic_pointer_cast<FIXUP_TARGET_SEGMENT>(target)->getTargetSegment()->getName();
+                mark_segment(final_obj, final_obj->getSegment(target_segment_name), marked_segments);
+            }
+            else if (target->getType() == FIXUP_TARGET_TYPE_EXTERN)
+            {
+                // As do global references
+                std::shared_ptr<GLOBAL_REF> global_ref = final_obj->getGlobalReferenceByName(std::dynamic_pointer_cast<FIXUP_TARGET_EXTERN>(target)->getExternalName());
+                if (global_ref != NULL)
+                {
+                    mark_segment(final_obj, final_obj->getSegment(global_ref->getSegment()->getName()), marked_segments);
+                }
+            }
+        }
+    }
+}
+
+bool Linker::is_root_segment(std::shared_ptr<VirtualSegment> segment)
+{
+    return !segment->isFunctionSection();
+}
+
+std::vector<std::shared_ptr<FIXUP>> Linker::get_sorted_fixups(std::shared_ptr<VirtualSegment> segment)
+{
+    std::vector<std::shared_ptr<FIXUP>> fixups = segment->getFixups();
+    std::stable_sort(fixups.begin(), fixups.end(), [](std::shared_ptr<FIXUP> fixup1, std::shared_ptr<FIXUP> fixup2) -> bool
+    {
+        return fixup1->getOffset() < fixup2->getOffset();
+    });
+    return fixups;
+}
+
+int Linker::read_fixup(std::shared_ptr<VirtualSegment> segment, char* buf, std::shared_ptr<FIXUP> fixup)
+{
+    check_fixup_bounds(segment, fixup);
+    return ReadFixupValue(buf + fixup->getOffset(), fixup->getLength(), fixup->getType() == FIXUP_TYPE_SELF_RELATIVE);
+}
+
+void Linker::apply_fixup(std::shared_ptr<VirtualSegment> segment, char* buf, std::shared_ptr<FIXUP> fixup, int value)
+{
+    check_fixup_bounds(segment, fixup);
+    int bits = GetFixupLengthAsInteger(fixup->getLength()) * 8;
+    if (bits < 32)
+    {
+        // Self relative fixups are distances so must fit signed, anything else may use the full unsigned range
+        long long min = -(1ll << (bits - 1));
+        long long max = fixup->getType() == FIXUP_TYPE_SELF_RELATIVE ? (1ll << (bits - 1)) - 1 : (1ll << bits) - 1;
+        if (value < min || value > max)
+        {
+            std::string message = "The value " + std::to_string(value) + " for " + get_fixup_target_name(fixup) + " does not fit the " + std::to_string(bits)
+                    + " bit fixup at offset " + std::to_string(fixup->getOffset()) + " of segment " + segment->getName();
+            std::string symbol = get_symbol_at(segment, fixup->getOffset());
+            if (symbol != "")
+            {
+                message += " in " + symbol;
+            }
+            throw LinkerException(message);
+        }
+    }
+
+    WriteFixupValue(buf + fixup->getOffset(), fixup->getLength(), value);
+}
+
+void Linker::check_fixup_bounds(std::shared_ptr<VirtualSegment> segment, std::shared_ptr<FIXUP> fixup)
+{
+    if (fixup->getOffset() < 0 || (size_t) (fixup->getOffset() + GetFixupLengthAsInteger(fixup->getLength())) > segment->getStream()->getSize())
+    {
+        throw LinkerException("The fixup at offset " + std::to_string(fixup->getOffset()) + " is outside of segment " + segment->getName());
+    }
+}
+
+std::string Linker::get_fixup_target_name(std::shared_ptr<FIXUP> fixup)
+{
+    std::shared_ptr<FIXUP_TARGET> target = fixup->getTarget();
+    if (target->getType() == FIXUP_TARGET_TYPE_EXTERN)
+    {
+        return std::dynamic_pointer_cast<FIXUP_TARGET_EXTERN>(target)->getExternalName();
+    }
+
+    return "segment " + std::dynamic_pointer_cast<FIXUP_TARGET_SEGMENT>(target)->getTargetSegment()->getName();
+}
+
+std::string Linker::get_symbol_at(std::shared_ptr<VirtualSegment> segment, int offset)
+{
+    // The closest global reference at or before the offset is the one the fixup is in
+    std::shared_ptr<GLOBAL_REF> closest_global_ref = NULL;
+    for (std::shared_ptr<GLOBAL_REF> global_ref : segment->getGlobalReferences())
+    {
+        if (global_ref->getOffset() <= offset
+                && (closest_global_ref == NULL || global_ref->getOffset() > closest_global_ref->getOffset()))
+        {
+            closest_global_ref = global_ref;
+        }
+    }
+
+    if (closest_global_ref == NULL)
+    {
+        return "";
+    }
+
+    return closest_global_ref->getName();
+}
+
 void Linker::link_merge(std::shared_ptr<VirtualObjectFormat> obj1, std::shared_ptr<VirtualObjectFormat> obj2)
 {
     // We need to merge the formats
@@ -159,4 +350,24 @@ void Linker::link_merge(std::shared_ptr<VirtualObjectFormat> obj1, std::shared_p
 Stream* Linker::getExecutableStream()
 {
     return &this->executable_stream;
+}
+
+std::vector<std::string> Linker::getReport()
+{
+    return this->report_messages;
+}
+
+void Linker::report(std::string message)
+{
+    this->report_messages.push_back(message);
+}
+
+std::vector<std::string> Linker::getWarnings()
+{
+    return this->warning_messages;
+}
+
+void Linker::warn(std::string message)
+{
+    this->warning_messages.push_back(message);
 }
\ No newline at end of file
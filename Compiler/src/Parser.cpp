@@ -75,6 +75,9 @@ Parser::Parser(Compiler* compiler) : CompilerEntity(compiler)
     this->current_function = NULL;
     this->compiler = compiler;
     this->did_return = false;
+    this->calling_convention = "";
+    this->no_inline = false;
+    this->is_static = false;
 }
 
 Parser::~Parser()
@@ -116,6 +119,28 @@ void Parser::process_top()
     this->root_scope = this->root_branch;
     start_local_scope(this->root_branch);
     peek();
+
+    /* Functions may be given attributes before their return type e.g "__regcall uint16 add(uint16 a, uint16 b)"
+     * "__regcall" and "__stackcall" set the calling convention, "__noinline" stops the function from being inlined
+     * and "__static" keeps the function private to this file */
+    while (is_peek_keyword("__regcall") || is_peek_keyword("__stackcall") || is_peek_keyword("__noinline") || is_peek_keyword("__static"))
+    {
+        shift_pop();
+        if (this->branch_value == "__noinline")
+        {
+            this->no_inline = true;
+        }
+        else if (this->branch_value == "__static")
+        {
+            this->is_static = true;
+        }
+        else
+        {
+            this->calling_convention = this->branch_value;
+        }
+        peek();
+    }
+
     if (is_peek_type("keyword"))
     {
         std::string keyword_value = this->peek_token_value;
@@ -233,6 +258,22 @@ void Parser::process_top()
         error_unexpected_token();
     }
 
+    // The calling convention is taken by the function it was given for, if its still here then it was given for something else
+    if (this->calling_convention != "")
+    {
+        error("The calling convention attribute \"" + this->calling_convention + "\" may only be given for functions");
+    }
+
+    if (this->no_inline)
+    {
+        error("The attribute \"__noinline\" may only be given for functions");
+    }
+
+    if (this->is_static)
+    {
+        error("The attribute \"__static\" may only be given for functions");
+    }
+
     finish_local_scope();
 }
 
@@ -489,6 +530,12 @@ void Parser::process_function()
     func_dec_branch->setReturnDataTypeBranch(data_type_branch);
     func_dec_branch->setNameBranch(func_name);
     func_dec_branch->setArgumentsBranch(func_arguments);
+    func_dec_branch->setCallingConvention(this->calling_convention);
+    func_dec_branch->setNoInline(this->no_inline);
+    func_dec_branch->setStatic(this->is_static);
+    this->calling_convention = "";
+    this->no_inline = false;
+    this->is_static = false;
 
     // Finish the local scope for the function arguments.
     finish_local_scope();
@@ -596,6 +643,21 @@ void Parser::process_stmt()
             // This is a "for" statement so process it
             process_for_stmt();
         }
+        else if (is_peek_value("switch"))
+        {
+            // This is a "switch" statement so process it
+            process_switch_stmt();
+        }
+        else if (is_peek_value("case"))
+        {
+            // This is a "case" of a switch statement so process it
+            process_case();
+        }
+        else if (is_peek_value("default"))
+        {
+            // This is the "default" of a switch statement so process it
+            process_default();
+        }
         else if (is_peek_value("return"))
         {
             // This is a "return" statement so process it
@@ -1510,6 +1572,92 @@ void Parser::process_while_stmt()
     push_branch(while_stmt);
 }
 
+void Parser::process_switch_stmt()
+{
+    // shift and pop the next token and make sure its a "switch" keyword
+    shift_pop();
+    if (!is_branch_keyword("switch"))
+    {
+        error_expecting("switch", this->branch_value);
+    }
+
+    // shift and pop the next token and make sure its a left bracket.
+    shift_pop();
+    if (!is_branch_symbol("("))
+    {
+        error_expecting("(", this->branch_value);
+    }
+
+    // Process the expression
+    process_expression();
+    // Pop off the expression result
+    pop_branch();
+    std::shared_ptr<Branch> exp = this->branch;
+
+    // Shift and pop the right bracket and make sure it is a right bracket
+    shift_pop();
+    if (!is_branch_symbol(")"))
+    {
+        error_expecting(")", this->branch_value);
+    }
+
+    // Process the body, the "case" and "default" statements within it mark where the switch may jump to
+    process_body();
+    // Pop off the body result
+    pop_branch();
+    std::shared_ptr<BODYBranch> body = std::dynamic_pointer_cast<BODYBranch>(this->branch);
+
+    // Time to put it all together
+    std::shared_ptr<SwitchBranch> switch_stmt = std::shared_ptr<SwitchBranch>(new SwitchBranch(getCompiler()));
+    switch_stmt->setExpressionBranch(exp);
+    switch_stmt->setBodyBranch(body);
+
+    // Finally push the switch statement to the tree
+    push_branch(switch_stmt);
+}
+
+void Parser::process_case()
+{
+    shift_pop();
+    if (!is_branch_keyword("case"))
+    {
+        error_expecting("case", this->branch_value);
+    }
+
+    // Process the value of this case
+    process_expression();
+    pop_branch();
+    std::shared_ptr<Branch> value = this->branch;
+
+    shift_pop();
+    if (!is_branch_symbol(":"))
+    {
+        error_expecting(":", this->branch_value);
+    }
+
+    std::shared_ptr<CaseBranch> case_branch = std::shared_ptr<CaseBranch>(new CaseBranch(getCompiler()));
+    case_branch->setValueBranch(value);
+    push_branch(case_branch);
+}
+
+void Parser::process_default()
+{
+    shift_pop();
+    if (!is_branch_keyword("default"))
+    {
+        error_expecting("default", this->branch_value);
+    }
+
+    shift_pop();
+    if (!is_branch_symbol(":"))
+    {
+        error_expecting(":", this->branch_value);
+    }
+
+    std::shared_ptr<DefaultBranch> default_branch = std::shared_ptr<DefaultBranch>(new DefaultBranch(getCompiler()));
+    push_branch(default_branch);
+}
+
 void Parser::process_for_stmt()
 {
     std::shared_ptr<FORBranch> for_stmt = std::shared_ptr<FORBranch>(new FORBranch(compiler));
@@ -2371,4 +2519,4 @@ std::shared_ptr<Tree> Parser::getTree()
 std::shared_ptr<Logger> Parser::getLogger()
 {
     return this->logger;
-}
\ No newline at end of file
+}
\ No newline at end of file
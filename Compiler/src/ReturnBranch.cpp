@@ -53,9 +53,9 @@ bool ReturnBranch::hasExpressionBranch()
 void ReturnBranch::imp_clone(std::shared_ptr<Branch> cloned_branch)
 {
     std::shared_ptr<ReturnBranch> return_branch_cloned = std::dynamic_pointer_cast<ReturnBranch>(cloned_branch);
-    if (return_branch_cloned->hasExpressionBranch())
+    if (hasExpressionBranch())
     {
-        return_branch_cloned->setExpressionBranch(return_branch_cloned->getExpressionBranch()->clone());
+        return_branch_cloned->setExpressionBranch(getExpressionBranch()->clone());
     }
 }
 
@@ -81,7 +81,7 @@ std::shared_ptr<FuncDefBranch> RootBranch::getDeclaredFunctionDefinitionByName(s
         }
     }
 
-    return false;
+    return NULL;
 }
 
 bool RootBranch::isFunctionDefinitionDeclared(std::string name)
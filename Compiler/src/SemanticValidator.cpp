@@ -141,6 +141,15 @@ void SemanticValidator::validate_part(std::shared_ptr<Branch> branch)
     {
         validate_if_stmt(std::dynamic_pointer_cast<IFBranch>(branch));
     }
+    else if (type == "SWITCH")
+    {
+        validate_switch_stmt(std::dynamic_pointer_cast<SwitchBranch>(branch));
+    }
+    else if (type == "CASE" || type == "DEFAULT")
+    {
+        // Switch statements validate their own cases, so if we are here this case is somewhere it should not be
+        logger->error("A \"" + std::string(type == "CASE" ? "case" : "default") + "\" must be directly within the body of a switch statement", branch);
+    }
     else if (type == "ADDRESS_OF")
     {
         validate_address_of(std::dynamic_pointer_cast<AddressOfBranch>(branch));
@@ -274,6 +283,47 @@ void SemanticValidator::validate_while_loop(std::shared_ptr<WhileBranch> while_b
     validate_part(while_branch->getBodyBranch());
 }
 
+void SemanticValidator::validate_switch_stmt(std::shared_ptr<SwitchBranch> switch_branch)
+{
+    struct semantic_information s_info;
+    validate_value(switch_branch->getExpressionBranch(), &s_info);
+
+    // The code generator compares the cases as words so duplicates are found the same way
+    std::set<int> case_values;
+    bool has_default = false;
+    for (std::shared_ptr<Branch> child : switch_branch->getBodyBranch()->getChildren())
+    {
+        if (child->getType() == "CASE")
+        {
+            std::shared_ptr<Branch> value_branch = std::dynamic_pointer_cast<CaseBranch>(child)->getValueBranch();
+            if (value_branch->getType() != "number")
+            {
+                this->logger->error("The value of a case must be a constant number", child);
+                continue;
+            }
+
+            int value = std::stoi(value_branch->getValue()) & 0xffff;
+            if (case_values.find(value) != case_values.end())
+            {
+                this->logger->error("The case \"" + value_branch->getValue() + "\" has already been used in this switch statement", child);
+            }
+            case_values.insert(value);
+        }
+        else if (child->getType() == "DEFAULT")
+        {
+            if (has_default)
+            {
+                this->logger->error("A switch statement may only have one \"default\"", child);
+            }
+            has_default = true;
+        }
+        else
+        {
+            validate_part(child);
+        }
+    }
+}
+
 void SemanticValidator::validate_if_stmt(std::shared_ptr<IFBranch> if_branch)
 {
     struct semantic_information s_info;
@@ -414,6 +464,15 @@ void SemanticValidator::validate_assignment(std::shared_ptr<AssignBranch> assign
     std::shared_ptr<VDEFBranch> vdef_branch = var_iden_branch->getVariableDefinitionBranch();
     std::string data_type = vdef_branch->getDataTypeBranch()->getDataType();
 
+    // Whole structures are copied rather than referenced e.g "a = b;"
+    if (var_to_assign_branch->getType() == "VAR_IDENTIFIER" && var_iden_branch->isVariableAlone()
+            && !vdef_branch->isPrimitive() && !vdef_branch->isPointer()
+            && !vdef_branch->getVariableIdentifierBranch()->hasRootArrayIndexBranch())
+    {
+        validate_structure_assignment(assign_branch, vdef_branch);
+        return;
+    }
+
     // Validate that the value is legal
     struct semantic_information s_info;
     s_info.sv_info.requirement_type = data_type;
@@ -422,6 +481,32 @@ void SemanticValidator::validate_assignment(std::shared_ptr<AssignBranch> assign
     validate_value(assign_branch->getValueBranch(), &s_info);
 }
 
+void SemanticValidator::validate_structure_assignment(std::shared_ptr<AssignBranch> assign_branch, std::shared_ptr<VDEFBranch> vdef_branch)
+{
+    std::string data_type = vdef_branch->getDataTypeBranch()->getDataType();
+    std::shared_ptr<Branch> value_branch = assign_branch->getValueBranch();
+    if (assign_branch->getOperator() != "=")
+    {
+        this->logger->error("Structures can only be assigned with \"=\"", assign_branch->getVariableToAssignBranch());
+        return;
+    }
+
+    std::shared_ptr<VarIdentifierBranch> value_var_iden_branch = std::dynamic_pointer_cast<VarIdentifierBranch>(value_branch);
+    if (value_var_iden_branch == NULL || !value_var_iden_branch->isVariableAlone())
+    {
+        this->logger->error("Structures can only be assigned another structure variable of type \"" + data_type + "\"", value_branch);
+        return;
+    }
+
+    std::shared_ptr<VDEFBranch> value_vdef_branch = value_var_iden_branch->getVariableDefinitionBranch();
+    if (value_vdef_branch->isPrimitive() || value_vdef_branch->isPointer()
+            || value_vdef_branch->getVariableIdentifierBranch()->hasRootArrayIndexBranch()
+            || value_vdef_branch->getDataTypeBranch()->getDataType() != data_type)
+    {
+        this->logger->error("Structures can only be assigned another structure variable of type \"" + data_type + "\"", value_branch);
+    }
+}
+
 void SemanticValidator::validate_for_stmt(std::shared_ptr<FORBranch> for_branch)
 {
     std::shared_ptr<Branch> init_branch = for_branch->getInitBranch();
@@ -729,6 +814,16 @@ void SemanticValidator::register_function(std::shared_ptr<FuncDefBranch> func_de
 {
     // Validate the function
     std::string func_name = func_def_branch->getNameBranch()->getValue();
+    if (hasFunction(func_name))
+    {
+        // Callers only see one of the definitions so they must all agree on how arguments are passed
+        std::shared_ptr<FuncDefBranch> registered_func_def_branch = getFunction(func_name);
+        if (registered_func_def_branch->isRegisterCall() != func_def_branch->isRegisterCall())
+        {
+            critical_error("The function: \"" + func_name + "\" has been declared with a different calling convention to a previous declaration", func_def_branch);
+        }
+    }
+
     if (hasFunctionDeclaration(func_name))
     {
         if (!func_def_branch->isOnlyDefinition())
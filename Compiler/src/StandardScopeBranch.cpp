@@ -48,6 +48,17 @@ int StandardScopeBranch::getScopeSize(GET_SCOPE_SIZE_OPTIONS options, std::funct
 
     for (std::shared_ptr<Branch> child : this->getChildren())
     {
+        if (child->getBranchType() == BRANCH_TYPE_VDEF)
+        {
+            // Pad up to the alignment the code generator wants for this variable, the padding comes before the variable so it is part of its position
+            std::shared_ptr<VDEFBranch> vdef_branch = std::dynamic_pointer_cast<VDEFBranch>(child);
+            int alignment = getCompiler()->getCodeGenerator()->getVariableAlignment(std::dynamic_pointer_cast<ScopeBranch>(this->getptr()), vdef_branch);
+            if (alignment > 1 && size % alignment != 0)
+            {
+                size += alignment - (size % alignment);
+            }
+        }
+
         if (!invoke_scope_size_proc_if_possible(elem_proc_start, child, should_stop))
         {
             stop = true;
@@ -32,6 +32,7 @@
 #include <string.h>
 #include <iostream>
 #include <map>
+#include <algorithm>
 
 Stream::Stream()
 {
@@ -176,6 +177,22 @@ void Stream::writeStr(const char* str, bool write_null_terminator, size_t fill_t
     }
 }
 
+void Stream::writeBuf(const char* buf, size_t size)
+{
+    // Joined streams must be told about every byte so only plain streams can take the buffer in one go
+    if (!this->joined_streams.empty() || !this->parent_joined_streams.empty() || isOverwriteModeEnabled())
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            write8(buf[i]);
+        }
+        return;
+    }
+
+    this->vector.insert(this->vector.begin() + this->pos, (uint8_t*) buf, (uint8_t*) buf + size);
+    this->pos += size;
+}
+
 void Stream::writeStream(Stream* stream, int offset, int total)
 {
     if (offset >= 0)
@@ -191,6 +208,16 @@ void Stream::writeStream(Stream* stream, int offset, int total)
         total = stream->getSize();
     }
 
+    // Copying from another stream can be done in one go, writing a stream into itself changes it as we read
+    if (stream != this)
+    {
+        if ((size_t) offset < stream->getSize())
+        {
+            writeBuf(stream->getBuf() + offset, std::min((size_t) total, stream->getSize() - offset));
+        }
+        return;
+    }
+
     int old_pos = stream->getPosition();
     stream->setPosition(offset);
     int total_wrote = 0;
@@ -0,0 +1,68 @@
+/*
+    Craft compiler v0.1.0 - The standard compiler for the Craft programming language.
+    Copyright (C) 2016  Daniel McCarthy
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* 
+ * File:   SwitchBranch.cpp
+ * Author: Daniel McCarthy
+ *
+ * Created on 18 October 2026, 14:20
+ * 
+ * Description: Holds a switch statement, its body contains the statements along with the "case" and "default" markers that are jumped to.
+ */
+
+#include "SwitchBranch.h"
+#include "BODYBranch.h"
+
+SwitchBranch::SwitchBranch(Compiler* compiler) : CustomBranch(compiler, "SWITCH", "")
+{
+}
+
+SwitchBranch::~SwitchBranch()
+{
+}
+
+void SwitchBranch::setExpressionBranch(std::shared_ptr<Branch> exp_branch)
+{
+    CustomBranch::registerBranch("exp_branch", exp_branch);
+}
+
+void SwitchBranch::setBodyBranch(std::shared_ptr<BODYBranch> body_branch)
+{
+    CustomBranch::registerBranch("body_branch", body_branch);
+}
+
+std::shared_ptr<Branch> SwitchBranch::getExpressionBranch()
+{
+    return CustomBranch::getRegisteredBranchByName("exp_branch");
+}
+
+std::shared_ptr<BODYBranch> SwitchBranch::getBodyBranch()
+{
+    return std::dynamic_pointer_cast<BODYBranch>(CustomBranch::getRegisteredBranchByName("body_branch"));
+}
+
+void SwitchBranch::imp_clone(std::shared_ptr<Branch> cloned_branch)
+{
+    std::shared_ptr<SwitchBranch> switch_branch_cloned = std::dynamic_pointer_cast<SwitchBranch>(cloned_branch);
+    switch_branch_cloned->setExpressionBranch(getExpressionBranch()->clone());
+    switch_branch_cloned->setBodyBranch(std::dynamic_pointer_cast<BODYBranch>(getBodyBranch()->clone()));
+}
+
+std::shared_ptr<Branch> SwitchBranch::create_clone()
+{
+    return std::shared_ptr<Branch>(new SwitchBranch(getCompiler()));
+}
\ No newline at end of file
@@ -81,6 +81,8 @@ std::shared_ptr<STRUCTDEFBranch> improvement::getStructDefFromStack(std::string
 TreeImprover::TreeImprover(Compiler* compiler) : CompilerEntity(compiler)
 {
     this->current_var_type = VARIABLE_TYPE_UNKNOWN;
+    this->total_unrolled_loops = 0;
+    this->total_fully_unrolled_loops = 0;
 }
 
 TreeImprover::~TreeImprover()
@@ -95,9 +97,21 @@ void TreeImprover::setTree(std::shared_ptr<Tree> tree)
 void TreeImprover::improve()
 {
     struct improvement improvement;
+    this->total_unrolled_loops = 0;
+    this->total_fully_unrolled_loops = 0;
     improve_top(&improvement);
 }
 
+int TreeImprover::getTotalUnrolledLoops()
+{
+    return this->total_unrolled_loops;
+}
+
+int TreeImprover::getTotalFullyUnrolledLoops()
+{
+    return this->total_fully_unrolled_loops;
+}
+
 void TreeImprover::improve_top(struct improvement* improvement)
 {
     this->tree->root->iterate_children([&](std::shared_ptr<Branch> child_branch)
@@ -134,6 +148,15 @@ void TreeImprover::improve_branch(std::shared_ptr<Branch> branch, struct improve
     {
         improve_for(std::dynamic_pointer_cast<FORBranch>(branch), improvement);
     }
+    else if (branch->getType() == "SWITCH")
+    {
+        improve_switch(std::dynamic_pointer_cast<SwitchBranch>(branch), improvement);
+    }
+    else if (branch->getType() == "CASE")
+    {
+        // Case values are improved so that constant expressions become the numbers the code generator needs
+        improve_branch(std::dynamic_pointer_cast<CaseBranch>(branch)->getValueBranch(), improvement);
+    }
     else if (branch->getType() == "PTR")
     {
         improve_ptr(std::dynamic_pointer_cast<PTRBranch>(branch), improvement);
@@ -347,12 +370,24 @@ void TreeImprover::improve_while(std::shared_ptr<WhileBranch> while_branch, stru
 
 }
 
+void TreeImprover::improve_switch(std::shared_ptr<SwitchBranch> switch_branch, struct improvement* improvement)
+{
+    // improve the expression of the switch statement
+    improve_branch(switch_branch->getExpressionBranch(), improvement);
+
+    // Improve the body of the switch statement, this will also improve the values of its cases
+    improve_body(switch_branch->getBodyBranch(), improvement);
+}
+
 void TreeImprover::improve_for(std::shared_ptr<FORBranch> for_branch, struct improvement* improvement)
 {
     improve_branch(for_branch->getInitBranch(), improvement);
     improve_branch(for_branch->getCondBranch(), improvement);
     improve_branch(for_branch->getLoopBranch(), improvement);
     improve_body(for_branch->getBodyBranch(), improvement);
+
+    // Small loops with known bounds may be unrolled
+    unroll_for(for_branch, improvement);
 }
 
 void TreeImprover::improve_ptr(std::shared_ptr<PTRBranch> ptr_branch, struct improvement* improvement)
@@ -360,6 +395,357 @@ void TreeImprover::improve_ptr(std::shared_ptr<PTRBranch> ptr_branch, struct imp
     improve_branch(ptr_branch->getExpressionBranch(), improvement);
 }
 
+int TreeImprover::getUnrollByteBudget()
+{
+    // Unrolling trades code size for speed so it is disabled entirely when optimizing for size
+    if (getCompiler()->hasArgument("Os"))
+    {
+        return 0;
+    }
+
+    if (getCompiler()->hasArgument("unroll_budget"))
+    {
+        return std::stoi(getCompiler()->getArgumentValue("unroll_budget"));
+    }
+
+    return UNROLL_DEFAULT_BYTE_BUDGET;
+}
+
+bool TreeImprover::is_index_var_iden(std::shared_ptr<Branch> branch, std::string index_name)
+{
+    if (branch->getType() != "VAR_IDENTIFIER")
+    {
+        return false;
+    }
+
+    // Variables accessed through a structure are not the index even if they share its name
+    if (branch->hasParent() && branch->getParent()->getType() == "STRUCT_ACCESS")
+    {
+        return false;
+    }
+
+    std::shared_ptr<VarIdentifierBranch> var_iden_branch = std::dynamic_pointer_cast<VarIdentifierBranch>(branch);
+    return var_iden_branch->getVariableNameBranch()->getValue() == index_name;
+}
+
+bool TreeImprover::get_unroll_trip_values(std::shared_ptr<FORBranch> for_branch, std::vector<int>* values)
+{
+    /* Works out every value the index of the loop will hold while running the body, this is only possible for loops such as:
+     * for (uint8 i = 0; i < 8; i += 1)
+     * where the start, the bound and the step are all numbers */
+    std::shared_ptr<Branch> init_branch = for_branch->getInitBranch();
+    std::shared_ptr<Branch> cond_branch = for_branch->getCondBranch();
+    std::shared_ptr<Branch> loop_branch = for_branch->getLoopBranch();
+    if (init_branch->getType() != "V_DEF")
+    {
+        return false;
+    }
+
+    std::shared_ptr<VDEFBranch> index_vdef_branch = std::dynamic_pointer_cast<VDEFBranch>(init_branch);
+    if (!index_vdef_branch->hasValueExpBranch()
+            || index_vdef_branch->getValueExpBranch()->getType() != "number"
+            || index_vdef_branch->isPointer()
+            || index_vdef_branch->getVariableIdentifierBranch()->hasRootArrayIndexBranch())
+    {
+        return false;
+    }
+
+    std::string index_name = index_vdef_branch->getVariableIdentifierBranch()->getVariableNameBranch()->getValue();
+    if (cond_branch->getType() != "E"
+            || !is_index_var_iden(cond_branch->getFirstChild(), index_name)
+            || cond_branch->getSecondChild()->getType() != "number"
+            || loop_branch->getType() != "ASSIGN")
+    {
+        return false;
+    }
+
+    // The loop must be "i += c", "i -= c", "i = i + c" or "i = i - c"
+    std::shared_ptr<AssignBranch> loop_assign_branch = std::dynamic_pointer_cast<AssignBranch>(loop_branch);
+    std::shared_ptr<Branch> loop_value_branch = loop_assign_branch->getValueBranch();
+    std::string op = loop_assign_branch->getOperator();
+    std::shared_ptr<Branch> step_branch = NULL;
+    if (!is_index_var_iden(loop_assign_branch->getVariableToAssignBranch(), index_name))
+    {
+        return false;
+    }
+
+    if (op == "+=" || op == "-=")
+    {
+        step_branch = loop_value_branch;
+        op = op.substr(0, 1);
+    }
+    else if (op == "=" && loop_value_branch->getType() == "E"
+            && is_index_var_iden(loop_value_branch->getFirstChild(), index_name))
+    {
+        step_branch = loop_value_branch->getSecondChild();
+        op = loop_value_branch->getValue();
+    }
+
+    if (step_branch == NULL
+            || step_branch->getType() != "number"
+            || (op != "+" && op != "-"))
+    {
+        return false;
+    }
+
+    int step = std::stoi(step_branch->getValue());
+    if (op == "-")
+    {
+        step = -step;
+    }
+
+    if (step == 0)
+    {
+        return false;
+    }
+
+    // The index must never leave the range of its type, otherwise we would have to model it wrapping around
+    int max = index_vdef_branch->getDataTypeBranch()->getDataTypeSize() == 1 ? 0xff : 0xffff;
+    int bound = std::stoi(cond_branch->getSecondChild()->getValue());
+    std::string cond_op = cond_branch->getValue();
+    int value = std::stoi(index_vdef_branch->getValueExpBranch()->getValue());
+    while (true)
+    {
+        bool holds;
+        if (cond_op == "<")
+            holds = value < bound;
+        else if (cond_op == "<=")
+            holds = value <= bound;
+        else if (cond_op == ">")
+            holds = value > bound;
+        else if (cond_op == ">=")
+            holds = value >= bound;
+        else if (cond_op == "!=")
+            holds = value != bound;
+        else
+            return false;
+
+        if (!holds)
+        {
+            break;
+        }
+
+        if (value < 0 || value > max || values->size() == UNROLL_MAX_TRIP_COUNT)
+        {
+            return false;
+        }
+
+        values->push_back(value);
+        value += step;
+    }
+
+    return true;
+}
+
+bool TreeImprover::is_unrollable_body(std::shared_ptr<Branch> branch, std::string index_name)
+{
+    /* The body is copied for every iteration so it must not declare anything or open new scopes,
+     * it also must not change the flow of the loop or the index itself */
+    std::string type = branch->getType();
+    if (type == "V_DEF" || type == "STRUCT_DEF" || type == "BODY" || type == "FOR" || type == "WHILE" || type == "IF"
+            || type == "BREAK" || type == "CONTINUE" || type == "RETURN" || type == "ASM")
+    {
+        return false;
+    }
+
+    if (type == "ASSIGN" && is_index_var_iden(std::dynamic_pointer_cast<AssignBranch>(branch)->getVariableToAssignBranch(), index_name))
+    {
+        return false;
+    }
+
+    if (type == "ADDRESS_OF" && is_index_var_iden(std::dynamic_pointer_cast<AddressOfBranch>(branch)->getVariableIdentifierBranch(), index_name))
+    {
+        return false;
+    }
+
+    for (std::shared_ptr<Branch> child : branch->getChildren())
+    {
+        if (!is_unrollable_body(child, index_name))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int TreeImprover::estimate_code_size(std::shared_ptr<Branch> branch)
+{
+    int size = UNROLL_ESTIMATED_BYTES_PER_BRANCH;
+    for (std::shared_ptr<Branch> child : branch->getChildren())
+    {
+        size += estimate_code_size(child);
+    }
+
+    return size;
+}
+
+std::shared_ptr<Branch> TreeImprover::clone_with_index(std::shared_ptr<Branch> branch, std::string index_name, std::function<std::shared_ptr<Branch>() > make_index_branch)
+{
+    // Clones the branch and replaces every use of the index with a branch provided by "make_index_branch"
+    std::shared_ptr<Branch> cloned_branch = branch->clone();
+    std::vector<std::shared_ptr<Branch>> index_branches;
+    std::function<void(std::shared_ptr<Branch>) > find_func = [&](std::shared_ptr<Branch> branch) -> void
+    {
+        if (is_index_var_iden(branch, index_name))
+        {
+            index_branches.push_back(branch);
+            return;
+        }
+
+        for (std::shared_ptr<Branch> child : branch->getChildren())
+        {
+            find_func(child);
+        }
+    };
+    find_func(cloned_branch);
+
+    for (std::shared_ptr<Branch> index_branch : index_branches)
+    {
+        index_branch->replaceSelf(make_index_branch());
+    }
+
+    return cloned_branch;
+}
+
+bool TreeImprover::unroll_for(std::shared_ptr<FORBranch> for_branch, struct improvement* improvement)
+{
+    /* Loops with a small number of iterations known at compile time are unrolled so that we do not pay for the compare and jump every time around.
+     * If the whole loop fits in the byte budget the loop is replaced with a copy of its body for each iteration with the index replaced by its value.
+     * Otherwise if the body is small enough we copy it 2 or 4 times inside the loop and step the index by that many iterations at a time,
+     * any iterations left over are placed after the loop with their index values known. */
+    int budget = getUnrollByteBudget();
+    std::shared_ptr<Branch> parent_branch = for_branch->getParent();
+    std::shared_ptr<BODYBranch> body_branch = for_branch->getBodyBranch();
+    std::vector<int> values;
+    if (budget <= 0
+            || parent_branch == NULL
+            || parent_branch->getType() != "BODY"
+            || !get_unroll_trip_values(for_branch, &values))
+    {
+        return false;
+    }
+
+    std::shared_ptr<VDEFBranch> index_vdef_branch = std::dynamic_pointer_cast<VDEFBranch>(for_branch->getInitBranch());
+    std::string index_name = index_vdef_branch->getVariableIdentifierBranch()->getVariableNameBranch()->getValue();
+    CharPos pos = std::dynamic_pointer_cast<Token>(index_vdef_branch->getValueExpBranch())->getPosition();
+    // The loop body itself is copied statement by statement so only scopes nested inside it are refused
+    for (std::shared_ptr<Branch> child : body_branch->getChildren())
+    {
+        if (!is_unrollable_body(child, index_name))
+        {
+            return false;
+        }
+    }
+
+    int body_size = 0;
+    for (std::shared_ptr<Branch> child : body_branch->getChildren())
+    {
+        body_size += estimate_code_size(child);
+    }
+
+    int trip_count = values.size();
+    int factor = 0;
+    if (body_size * trip_count <= budget)
+    {
+        // The whole loop fits
+        factor = trip_count;
+    }
+    else if (trip_count >= 8 && body_size * 4 <= budget)
+    {
+        factor = 4;
+    }
+    else if (trip_count >= 4 && body_size * 2 <= budget)
+    {
+        factor = 2;
+    }
+    else
+    {
+        return false;
+    }
+
+    // Iterations that do not fit in a whole unrolled step of the loop are placed after it
+    int first_leftover = (factor == trip_count ? 0 : trip_count - trip_count % factor);
+    std::shared_ptr<Branch> branch_after_loop = NULL;
+    std::vector<std::shared_ptr<Branch>> parent_children = parent_branch->getChildren();
+    for (size_t i = 0; i + 1 < parent_children.size(); i++)
+    {
+        if (parent_children[i] == for_branch)
+        {
+            branch_after_loop = parent_children[i + 1];
+            break;
+        }
+    }
+
+    std::vector<std::shared_ptr<Branch>> new_branches;
+    for (int i = first_leftover; i < trip_count; i++)
+    {
+        int value = values[i];
+        for (std::shared_ptr<Branch> child : body_branch->getChildren())
+        {
+            std::shared_ptr<Branch> new_branch = clone_with_index(child, index_name, [&]() -> std::shared_ptr<Branch>
+            {
+                return std::shared_ptr<Token>(new Token("number", std::to_string(value), pos));
+            });
+            new_branch->setLocalScope(std::dynamic_pointer_cast<ScopeBranch>(parent_branch), true);
+            parent_branch->addChild(new_branch, branch_after_loop);
+            new_branches.push_back(new_branch);
+        }
+    }
+
+    this->total_unrolled_loops++;
+    if (factor == trip_count)
+    {
+        // Nothing is left of the loop
+        for_branch->removeSelf();
+        this->total_fully_unrolled_loops++;
+    }
+    else
+    {
+        /* Copy the body for the extra iterations in each step of the loop, the copies use "i + n" for the index
+         * and then make the loop stop before the leftovers and step over all the copies */
+        std::vector<std::shared_ptr<Branch>> body_children = body_branch->getChildren();
+        int step = values[1] - values[0];
+        for (int n = 1; n < factor; n++)
+        {
+            for (std::shared_ptr<Branch> child : body_children)
+            {
+                std::shared_ptr<Branch> new_branch = clone_with_index(child, index_name, [&]() -> std::shared_ptr<Branch>
+                {
+                    std::shared_ptr<VarIdentifierBranch> index_var_iden_branch = std::dynamic_pointer_cast<VarIdentifierBranch>(index_vdef_branch->getVariableIdentifierBranch()->clone());
+                    std::shared_ptr<EBranch> exp_branch = std::shared_ptr<EBranch>(new EBranch(getCompiler(), step < 0 ? "-" : "+"));
+                    exp_branch->addChild(index_var_iden_branch);
+                    exp_branch->addChild(std::shared_ptr<Token>(new Token("number", std::to_string(std::abs(step * n)), pos)));
+                    return exp_branch;
+                });
+                new_branch->setLocalScope(body_branch, true);
+                body_branch->addChild(new_branch);
+                new_branches.push_back(new_branch);
+            }
+        }
+
+        std::shared_ptr<Branch> cond_branch = for_branch->getCondBranch();
+        std::shared_ptr<AssignBranch> loop_assign_branch = std::dynamic_pointer_cast<AssignBranch>(for_branch->getLoopBranch());
+        std::shared_ptr<Branch> step_branch = loop_assign_branch->getValueBranch();
+        if (step_branch->getType() == "E")
+        {
+            step_branch = step_branch->getSecondChild();
+        }
+
+        cond_branch->getSecondChild()->replaceSelf(std::shared_ptr<Token>(new Token("number", std::to_string(values[first_leftover - 1] + step), pos)));
+        cond_branch->setValue("!=");
+        step_branch->replaceSelf(std::shared_ptr<Token>(new Token("number", std::to_string(std::abs(step * factor)), pos)));
+    }
+
+    // The index is now known in the copies so lets fold what we can
+    for (std::shared_ptr<Branch> new_branch : new_branches)
+    {
+        improve_branch(new_branch, improvement);
+    }
+
+    return true;
+}
+
 void TreeImprover::improve_expression(std::shared_ptr<EBranch> expression_branch, struct improvement* improvement, bool is_root)
 {
     std::shared_ptr<Branch> left_branch = expression_branch->getFirstChild();
@@ -252,6 +252,7 @@ void VDEFBranch::imp_clone(std::shared_ptr<Branch> cloned_branch)
     {
         vdef_branch_clone->setValueExpBranch(getValueExpBranch()->clone());
     }
+    vdef_branch_clone->setVariableType(getVariableType());
 }
 
 std::shared_ptr<Branch> VDEFBranch::create_clone()
@@ -30,6 +30,7 @@
 #include <iostream>
 #include <algorithm>
 #include <map>
+#include <unordered_map>
 
 VirtualObjectFormat::VirtualObjectFormat(Compiler* compiler) : CompilerEntity(compiler)
 {
@@ -79,6 +80,39 @@ bool VirtualObjectFormat::hasSegment(std::string segment_name)
     return getSegment(segment_name) != NULL;
 }
 
+void VirtualObjectFormat::removeSegment(std::shared_ptr<VirtualSegment> segment)
+{
+    std::vector<std::shared_ptr<VirtualSegment>>::iterator it = std::find(this->segments.begin(), this->segments.end(), segment);
+    if (it == this->segments.end())
+    {
+        throw Exception("The segment: " + segment->getName() + " does not belong to this object", "void VirtualObjectFormat::removeSegment(std::shared_ptr<VirtualSegment> segment)");
+    }
+    this->segments.erase(it);
+
+    // Its global references go with it, including those of segments appended to it
+    for (std::shared_ptr<VirtualSegment> part : segment->getParts())
+    {
+        for (std::shared_ptr<GLOBAL_REF> global_ref : part->getGlobalReferences())
+        {
+            std::unordered_map<std::string, std::shared_ptr<GLOBAL_REF>>::iterator ref_it = this->global_reference_table.find(global_ref->getName());
+            if (ref_it != this->global_reference_table.end() && ref_it->second == global_ref)
+            {
+                this->global_reference_table.erase(ref_it);
+            }
+        }
+    }
+}
+
+int VirtualObjectFormat::getSegmentPosition(std::shared_ptr<VirtualSegment> segment)
+{
+    if (!hasSegment(segment->getName()))
+    {
+        return 0;
+    }
+
+    return getSegment(segment->getName())->getPartPosition(segment);
+}
+
 void VirtualObjectFormat::registerGlobalReference(std::shared_ptr<VirtualSegment> segment, std::string ref_name, int offset)
 {
     if (segment == NULL)
@@ -86,7 +120,9 @@ void VirtualObjectFormat::registerGlobalReference(std::shared_ptr<VirtualSegment
         throw Exception("void VirtualObjectFormat::registerGlobalReference(std::shared_ptr<VirtualSegment> segment, std::string ref_name, int offset): expecting a segment but NULL was provided");
     }
 
-    segment->register_global_reference(ref_name, offset);
+    std::shared_ptr<GLOBAL_REF> global_ref = segment->register_global_reference(ref_name, offset);
+    // The assembler registers a global for both its "global" directive and its label so the first registration is the one that is looked up
+    this->global_reference_table.emplace(ref_name, global_ref);
 }
 
 std::vector<std::shared_ptr<GLOBAL_REF>> VirtualObjectFormat::getGlobalReferences()
@@ -108,24 +144,18 @@ std::vector<std::shared_ptr<GLOBAL_REF>> VirtualObjectFormat::getGlobalReference
 
 bool VirtualObjectFormat::hasGlobalReference(std::string ref_name)
 {
-    for (std::shared_ptr<VirtualSegment> segment : getSegments())
-    {
-        if (segment->hasGlobalReference(ref_name))
-            return true;
-    }
-
-    return false;
+    return this->global_reference_table.find(ref_name) != this->global_reference_table.end();
 }
 
 std::shared_ptr<GLOBAL_REF> VirtualObjectFormat::getGlobalReferenceByName(std::string ref_name)
 {
-    for (std::shared_ptr<VirtualSegment> segment : getSegments())
+    std::unordered_map<std::string, std::shared_ptr<GLOBAL_REF>>::iterator it = this->global_reference_table.find(ref_name);
+    if (it == this->global_reference_table.end())
     {
-        if (segment->hasGlobalReference(ref_name))
-            return segment->getGlobalReferenceByName(ref_name);
+        return NULL;
     }
 
-    return NULL;
+    return it->second;
 }
 
 void VirtualObjectFormat::registerExternalReference(std::string ref_name)
@@ -165,7 +195,16 @@ void VirtualObjectFormat::append(std::shared_ptr<VirtualObjectFormat> obj_format
         registerExternalReference(ext_ref);
     }
 
-    // Merge all the same segments together
+    // A global may only be defined by one object file
+    for (std::shared_ptr<GLOBAL_REF> global : obj_format->getGlobalReferences())
+    {
+        if (hasGlobalReference(global->getName()))
+        {
+            throw Exception("Duplicate definition: " + global->getName() + " is defined in more than one object file", "void VirtualObjectFormat::append(std::shared_ptr<VirtualObjectFormat> obj_format)");
+        }
+    }
+
+    // Append each segment to ours of the same name, nothing is copied or rebased until the linker needs it
     for (std::shared_ptr<VirtualSegment> segment : obj_format->getSegments())
     {
         std::shared_ptr<VirtualSegment> main_segment;
@@ -176,63 +215,20 @@ void VirtualObjectFormat::append(std::shared_ptr<VirtualObjectFormat> obj_format
         else
         {
             main_segment = createSegment(segment->getName());
+            main_segment->setUninitialized(segment->isUninitialized());
         }
 
-        // Lets join their streams to the main segment stream
-        std::shared_ptr<Stream> main_segment_stream = main_segment->getStream();
-        std::shared_ptr<Stream> segment_stream = segment->getStream();
-        main_segment_stream->joinStream(segment_stream);
-    }
-
-    // Apply fixups where appropriate
-    for (std::shared_ptr<VirtualSegment> segment : obj_format->getSegments())
-    {
-        std::shared_ptr<VirtualSegment> main_segment = getSegment(segment->getName());
-        std::shared_ptr<Stream> main_segment_stream = main_segment->getStream();
-        std::shared_ptr<Stream> segment_stream = segment->getStream();
-
-        int abs_segment_pos = main_segment_stream->getJoinedStreamPosition(segment_stream);
-
-        // Handle fixups
-        for (std::shared_ptr<FIXUP> fixup : segment->getFixups())
+        if (main_segment->isUninitialized() != segment->isUninitialized())
         {
-            std::shared_ptr<FIXUP_TARGET> target = fixup->getTarget();
-            if (target->getType() == FIXUP_TARGET_TYPE_SEGMENT)
-            {
-                std::shared_ptr<FIXUP_TARGET_SEGMENT> fixup_target_segment = std::dynamic_pointer_cast<FIXUP_TARGET_SEGMENT>(target);
-                // We need the absolute position of the segment on the main stream
-                std::shared_ptr<VirtualSegment> target_segment = fixup_target_segment->getTargetSegment();
-                std::shared_ptr<VirtualSegment> main_target_segment = getSegment(target_segment->getName());
-                int fixup_offset = fixup->getOffset();
-                int abs_pos_to_stream = main_target_segment->getStream()->getJoinedStreamPosition(target_segment->getStream());
-                int new_pos;
-                // Now lets fix the offset
-                switch (fixup->getLength())
-                {
-                case FIXUP_8BIT:
-                    new_pos = abs_pos_to_stream + segment_stream->peek8(fixup_offset);
-                    segment_stream->overwrite8(fixup_offset, new_pos);
-                    break;
-                case FIXUP_16BIT:
-                    new_pos = abs_pos_to_stream + segment_stream->peek16(fixup_offset);
-                    segment_stream->overwrite16(fixup_offset, new_pos);
-                    break;
-                case FIXUP_32BIT:
-                    new_pos = abs_pos_to_stream + segment_stream->peek32(fixup_offset);
-                    segment_stream->overwrite32(fixup_offset, new_pos);
-                    break;
-                }
-            }
-            // We need to add the fixup to the main segment
-            int new_offset_pos = abs_segment_pos + fixup->getOffset();
-            main_segment->register_fixup(fixup->getTarget(), fixup->getType(), new_offset_pos, fixup->getLength());
+            throw Exception("The segment: " + segment->getName() + " is uninitialized in one object file but not in another", "void VirtualObjectFormat::append(std::shared_ptr<VirtualObjectFormat> obj_format)");
         }
 
-        // Handle globals
-        for (std::shared_ptr<GLOBAL_REF> global : segment->getGlobalReferences())
-        {
-            int new_offset_pos = abs_segment_pos + global->getOffset();
-            main_segment->register_global_reference(global->getName(), new_offset_pos);
-        }
+        main_segment->appendSegment(segment);
+    }
+
+    // The appended segments keep their global references, we just need to be able to find them
+    for (std::shared_ptr<GLOBAL_REF> global : obj_format->getGlobalReferences())
+    {
+        this->global_reference_table.emplace(global->getName(), global);
     }
 }
@@ -182,6 +182,9 @@ VirtualSegment::VirtualSegment(std::string segment_name, uint32_t origin)
 {
     this->segment_name = segment_name;
     this->origin = origin;
+    this->alignment = 1;
+    this->uninitialized = false;
+    this->uninitialized_size = 0;
 
     this->stream = std::shared_ptr<Stream>(new Stream());
 }
@@ -200,6 +203,97 @@ std::shared_ptr<Stream> VirtualSegment::getStream()
     return this->stream;
 }
 
+void VirtualSegment::setStream(std::shared_ptr<Stream> stream)
+{
+    // The new bytes replace those of the appended segments so anything pointing into them must already point into the new stream
+    materialize();
+    this->part_positions.clear();
+    this->stream = stream;
+}
+
+void VirtualSegment::appendSegment(std::shared_ptr<VirtualSegment> segment)
+{
+    if (segment->isUninitialized() != isUninitialized())
+    {
+        throw Exception("The segment: " + segment->getName() + " cannot be appended to the segment: " + getName() + " as only one of them is uninitialized", "void VirtualSegment::appendSegment(std::shared_ptr<VirtualSegment> segment)");
+    }
+
+    // We only keep one level of appended segments
+    segment->materialize();
+
+    // The appended segment may need to start on a boundary, this segment must then be aligned as strictly
+    int size = getSize();
+    int position = size + (segment->getAlignment() - (size % segment->getAlignment())) % segment->getAlignment();
+    setAlignment(std::max(getAlignment(), segment->getAlignment()));
+
+    this->appended_segments.push_back(segment);
+    this->part_positions[segment] = position;
+}
+
+std::vector<std::shared_ptr<VirtualSegment>> VirtualSegment::getParts()
+{
+    std::vector<std::shared_ptr<VirtualSegment>> parts;
+    parts.push_back(shared_from_this());
+    parts.insert(parts.end(), this->appended_segments.begin(), this->appended_segments.end());
+    return parts;
+}
+
+int VirtualSegment::getPartPosition(std::shared_ptr<VirtualSegment> segment)
+{
+    std::map<std::shared_ptr<VirtualSegment>, int>::iterator it = this->part_positions.find(segment);
+    if (it == this->part_positions.end())
+    {
+        return 0;
+    }
+
+    return it->second;
+}
+
+bool VirtualSegment::hasAppendedSegments()
+{
+    return !this->appended_segments.empty();
+}
+
+void VirtualSegment::materialize()
+{
+    if (!hasAppendedSegments())
+    {
+        return;
+    }
+
+    // Work out the full size while we still know about the appended segments
+    int size = getSize();
+    for (std::shared_ptr<VirtualSegment> segment : this->appended_segments)
+    {
+        int position = this->part_positions[segment];
+        if (!isUninitialized())
+        {
+            // Zero the padding up to where the segment starts
+            while (this->stream->getSize() < (size_t) position)
+            {
+                this->stream->write8(0);
+            }
+            this->stream->writeStream(segment->getStream());
+        }
+
+        for (std::shared_ptr<FIXUP> fixup : segment->getFixups())
+        {
+            register_fixup(fixup->getTarget(), fixup->getType(), position + fixup->getOffset(), fixup->getLength());
+        }
+
+        for (std::shared_ptr<GLOBAL_REF> global_ref : segment->getGlobalReferences())
+        {
+            register_global_reference(global_ref->getName(), position + global_ref->getOffset());
+        }
+    }
+    this->appended_segments.clear();
+
+    if (isUninitialized())
+    {
+        this->uninitialized_size = size;
+    }
+}
+
 void VirtualSegment::register_fixup(std::shared_ptr<FIXUP_TARGET> fixup_target, FIXUP_TYPE fixup_type, int offset, FIXUP_LENGTH length)
 {
     std::shared_ptr<FIXUP> fixup = std::shared_ptr<FIXUP>(new FIXUP(shared_from_this(), fixup_target, fixup_type, offset, length));
@@ -222,10 +316,11 @@ void VirtualSegment::register_fixup_target_extern(FIXUP_TYPE fixup_type, std::st
     register_fixup(target, fixup_type, offset, length);
 }
 
-void VirtualSegment::register_global_reference(std::string ref_name, int offset)
+std::shared_ptr<GLOBAL_REF> VirtualSegment::register_global_reference(std::string ref_name, int offset)
 {
     std::shared_ptr<GLOBAL_REF> global_reference = std::shared_ptr<GLOBAL_REF>(new GLOBAL_REF(shared_from_this(), ref_name, offset));
     this->global_references.push_back(global_reference);
+    return global_reference;
 }
 
 std::vector<std::shared_ptr<FIXUP>> VirtualSegment::getFixups()
@@ -240,7 +335,7 @@ bool VirtualSegment::hasFixups()
     return !this->fixups.empty();
 }
 
-std::vector<std::shared_ptr<GLOBAL_REF>> VirtualSegment::getGlobalReferences()
+const std::vector<std::shared_ptr<GLOBAL_REF>>& VirtualSegment::getGlobalReferences()
 {
 
     return this->global_references;
@@ -261,7 +356,7 @@ std::shared_ptr<GLOBAL_REF> VirtualSegment::getGlobalReferenceByName(std::string
 bool VirtualSegment::hasGlobalReferences()
 {
 
-    return !getGlobalReferences().empty();
+    return !this->global_references.empty();
 }
 
 bool VirtualSegment::hasGlobalReference(std::string ref_name)
@@ -276,6 +371,11 @@ bool VirtualSegment::hasGlobalReference(std::string ref_name)
     return false;
 }
 
+bool VirtualSegment::isFunctionSection()
+{
+    return this->segment_name.compare(0, std::string(FUNCTION_SECTION_PREFIX).length(), FUNCTION_SECTION_PREFIX) == 0;
+}
+
 bool VirtualSegment::hasOrigin()
 {
     return this->origin != 0;
@@ -284,4 +384,67 @@ bool VirtualSegment::hasOrigin()
 uint32_t VirtualSegment::getOrigin()
 {
     return this->origin;
+}
+
+void VirtualSegment::setAlignment(int alignment)
+{
+    // Alignments are used to pad segments so anything but a power of two would break them
+    if (alignment <= 0 || (alignment & (alignment - 1)) != 0)
+    {
+        throw Exception("The segment " + this->segment_name + " cannot have an alignment of " + std::to_string(alignment) + " as it is not a power of two", "void VirtualSegment::setAlignment(int alignment)");
+    }
+    this->alignment = alignment;
+}
+
+int VirtualSegment::getAlignment()
+{
+    return this->alignment;
+}
+
+void VirtualSegment::setUninitialized(bool uninitialized)
+{
+    if (uninitialized && this->stream->getSize() != 0)
+    {
+        throw Exception("The segment \"" + this->segment_name + "\" already holds bytes so it cannot be made uninitialized", "void VirtualSegment::setUninitialized(bool uninitialized)");
+    }
+    this->uninitialized = uninitialized;
+}
+
+bool VirtualSegment::isUninitialized()
+{
+    return this->uninitialized;
+}
+
+void VirtualSegment::reserve(int size)
+{
+    // Reserved bytes go on the end of the segment so the appended segments must be in place first
+    materialize();
+
+    if (this->uninitialized)
+    {
+        // Uninitialized segments hold no bytes so we just remember how large they are
+        this->uninitialized_size += size;
+        return;
+    }
+
+    for (int i = 0; i < size; i++)
+    {
+        this->stream->write8(0);
+    }
+}
+
+int VirtualSegment::getSize()
+{
+    if (hasAppendedSegments())
+    {
+        std::shared_ptr<VirtualSegment> last_segment = this->appended_segments.back();
+        return this->part_positions[last_segment] + last_segment->getSize();
+    }
+
+    if (this->uninitialized)
+    {
+        return this->uninitialized_size;
+    }
+
+    return this->stream->getSize();
 }
\ No newline at end of file
@@ -130,6 +130,16 @@ void debug_virtual_object_format_segment(std::shared_ptr<VirtualSegment> segment
         std::cout << "\t" << "No global exported references to display" << std::endl;
     }
 
+    // Segments appended from other object files keep their own fixups and global references
+    for (std::shared_ptr<VirtualSegment> part : segment->getParts())
+    {
+        if (part != segment)
+        {
+            std::cout << "\t" << "Appended segment at position: " << segment->getPartPosition(part) << std::endl;
+            debug_virtual_object_format_segment(part);
+        }
+    }
+
 }
 
 void debug_virtual_object_format(std::shared_ptr<VirtualObjectFormat> virtual_object_format)
@@ -230,7 +240,35 @@ int EXPORT GetFixupLengthAsInteger(FIXUP_LENGTH fixup_len)
     return len;
 }
 
+int EXPORT ReadFixupValue(const char* buf, FIXUP_LENGTH fixup_len, bool is_signed)
+{
+    const uint8_t* bytes = (const uint8_t*) buf;
+    switch (fixup_len)
+    {
+    case FIXUP_8BIT:
+        return is_signed ? (int8_t) bytes[0] : bytes[0];
+    case FIXUP_16BIT:
+    {
+        uint16_t value = bytes[0] | (bytes[1] << 8);
+        return is_signed ? (int16_t) value : value;
+    }
+    case FIXUP_32BIT:
+        return (int) (bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t) bytes[3] << 24));
+    }
+
+    throw Exception("Invalid fixup length provided", "int ReadFixupValue(const char* buf, FIXUP_LENGTH fixup_len, bool is_signed)");
+}
+
+void EXPORT WriteFixupValue(char* buf, FIXUP_LENGTH fixup_len, int value)
+{
+    int len = GetFixupLengthAsInteger(fixup_len);
+    for (int i = 0; i < len; i++)
+    {
+        buf[i] = (value >> (i * 8)) & 0xff;
+    }
+}
+
 std::string EXPORT GetCompilerName()
 {
     return COMPILER_FULLNAME;
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -28,6 +28,12 @@
 #include <memory>
 #include <fstream>
 #include <string>
+#include <map>
+#include <set>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <functional>
 #include "def.h"
 #include "Compiler.h"
 #include "branches.h"
@@ -38,6 +44,7 @@
 #include "CodeGenerator.h"
 #include "CodeGeneratorException.h"
 #include "Linker.h"
+#include "Archive.h"
 #include "Preprocessor.h"
 
 using namespace std;
@@ -62,7 +69,8 @@ enum
     ERROR_WITH_CODEGENERATOR = 12,
     ERROR_WITH_PREPROCESSOR = 13,
     ERROR_WITH_OBJECT_FORMAT = 14,
-    ERROR_WITH_LINKER = 15
+    ERROR_WITH_LINKER = 15,
+    ERROR_WITH_ARCHIVE = 16
 } CompilerErrorCode;
 
 Compiler compiler;
@@ -71,6 +79,8 @@ Lexer* lexer;
 Parser* parser;
 SemanticValidator* semanticValidator;
 TreeImprover* treeImprover;
+FunctionInliner* functionInliner;
+DeadCodeEliminator* deadCodeEliminator;
 Preprocessor* preprocessor;
 
 std::string codegen_name;
@@ -83,6 +93,23 @@ bool object_file_output = false;
 
 ArgumentContainer arguments;
 
+// Key = object format name, value = the "Init" function of its library so each library is only loaded once
+std::map<std::string, VirtualObjFormatInitFunc> object_format_init_funcs;
+
+struct object_file_load
+{
+    std::string file_name;
+    std::string file_ext;
+    std::shared_ptr<VirtualObjectFormat> obj_format;
+    // The file as it was loaded, kept so archives can store it as it is
+    std::shared_ptr<Stream> stream;
+    // Set should the file fail to load or read
+    bool failed;
+    std::string error_message;
+    // Set should reading throw something other than an Exception, it is rethrown once every thread has finished
+    std::exception_ptr unexpected_exception;
+};
+
 std::shared_ptr<Linker> getLinker(std::string linker_name)
 {
     std::shared_ptr<Linker> linker = NULL;
@@ -109,9 +136,14 @@ std::shared_ptr<Linker> getLinker(std::string linker_name)
     return linker;
 }
 
-std::shared_ptr<VirtualObjectFormat> getObjectFormat(std::string object_format_name)
+VirtualObjFormatInitFunc getObjectFormatInitFunc(std::string object_format_name)
 {
-    std::shared_ptr<VirtualObjectFormat> virtual_obj_format = NULL;
+    std::map<std::string, VirtualObjFormatInitFunc>::iterator it = object_format_init_funcs.find(object_format_name);
+    if (it != object_format_init_funcs.end())
+    {
+        return it->second;
+    }
+
     void* lib_addr = GoblinLoadLibrary(std::string(std::string(OBJ_FORMAT_DIR)
                                                    + "/" + object_format_name + std::string(LIBRARY_EXT)).c_str());
     if (lib_addr == NULL)
@@ -125,6 +157,15 @@ std::shared_ptr<VirtualObjectFormat> getObjectFormat(std::string object_format_n
         throw Exception("The virtual object format: " + object_format_name + " does not have a valid \"Init\" function");
     }
 
+    object_format_init_funcs[object_format_name] = init_func;
+    return init_func;
+}
+
+std::shared_ptr<VirtualObjectFormat> getObjectFormat(std::string object_format_name)
+{
+    std::shared_ptr<VirtualObjectFormat> virtual_obj_format = NULL;
+    VirtualObjFormatInitFunc init_func = getObjectFormatInitFunc(object_format_name);
+
     virtual_obj_format = std::shared_ptr<VirtualObjectFormat>(init_func(&compiler));
 
     if (virtual_obj_format == NULL)
@@ -174,6 +215,58 @@ std::string getFileExtension(std::string filename)
     return split.at(split.size() - 1);
 }
 
+/* Loads and reads the object files on as many threads as there are cores. 
+ * The object formats must already be created as plugin libraries are loaded on this thread alone */
+void LoadObjectFiles(std::vector<struct object_file_load>* loads)
+{
+    std::atomic<unsigned int> next_load(0);
+    std::function<void() > load_worker = [&]() -> void
+    {
+        unsigned int index;
+        while ((index = next_load++) < loads->size())
+        {
+            struct object_file_load* load = &loads->at(index);
+            try
+            {
+                load->stream = LoadFile(load->file_name);
+                load->obj_format->read(load->stream);
+            }
+            catch (Exception ex)
+            {
+                load->failed = true;
+                load->error_message = ex.getMessage();
+            }
+            catch (...)
+            {
+                // An exception escaping a thread would terminate the program so we keep it until the threads are joined
+                load->unexpected_exception = std::current_exception();
+            }
+        }
+    };
+
+    unsigned int total_threads = std::max(1u, std::min(std::thread::hardware_concurrency(), (unsigned int) loads->size()));
+    std::vector<std::thread> threads;
+    // This thread works as well so we start one less
+    for (unsigned int i = 1; i < total_threads; i++)
+    {
+        threads.push_back(std::thread(load_worker));
+    }
+    load_worker();
+
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    for (struct object_file_load& load : *loads)
+    {
+        if (load.unexpected_exception != NULL)
+        {
+            std::rethrow_exception(load.unexpected_exception);
+        }
+    }
+}
+
 bool handle_parser_errors_and_warnings()
 {
     std::shared_ptr<Logger> logger = parser->getLogger();
@@ -323,6 +416,8 @@ int GenerateMode()
     preprocessor = compiler.getPreprocessor();
     semanticValidator = compiler.getSemanticValidator();
     treeImprover = compiler.getTreeImprover();
+    functionInliner = compiler.getFunctionInliner();
+    deadCodeEliminator = compiler.getDeadCodeEliminator();
 
     lexer->setFilename(input_file_name);
     lexer->setInput(source_file_data);
@@ -412,6 +507,30 @@ int GenerateMode()
         return ERROR_WITH_SEMANTIC_VALIDATION;
     }
 
+    // Inline small functions now that we know the tree is valid
+    try
+    {
+        functionInliner->setTree(parser->getTree());
+        functionInliner->inline_functions();
+    }
+    catch (Exception ex)
+    {
+        std::cout << "Error with inlining functions: " << ex.getMessage() << std::endl;
+        return ERROR_WITH_TREE_IMPROVER;
+    }
+
+    // Inlining may have left functions with nothing calling them so we remove dead code afterwards
+    try
+    {
+        deadCodeEliminator->setTree(parser->getTree());
+        deadCodeEliminator->eliminate();
+    }
+    catch (Exception ex)
+    {
+        std::cout << "Error with eliminating dead code: " << ex.getMessage() << std::endl;
+        return ERROR_WITH_TREE_IMPROVER;
+    }
+
 #ifdef DEBUG_MODE
     debug_output_branch(parser->getTree()->root);
 #endif 
@@ -420,6 +539,20 @@ int GenerateMode()
         codegen->generate(parser->getTree());
         codegen->assemble();
 
+        if (arguments.hasArgument("report"))
+        {
+            std::cout << "Loops unrolled: " << treeImprover->getTotalUnrolledLoops() << " (" << treeImprover->getTotalFullyUnrolledLoops() << " fully)" << std::endl;
+            std::cout << "Function calls inlined: " << functionInliner->getTotalInlinedCalls() << std::endl;
+            for (std::string message : deadCodeEliminator->getReport())
+            {
+                std::cout << message << std::endl;
+            }
+            for (std::string message : codegen->getReport())
+            {
+                std::cout << message << std::endl;
+            }
+        }
+
         // Finalize the object
         std::shared_ptr<VirtualObjectFormat> obj_format = codegen->getObjectFormat();
         obj_format->finalize();
@@ -442,6 +575,7 @@ int LinkMode()
 {
     std::vector<std::string> file_names_to_link;
     std::vector<std::shared_ptr < VirtualObjectFormat>> obj_files;
+    std::vector<std::shared_ptr<Archive>> archives;
 
     if (!arguments.hasArgument("input"))
     {
@@ -475,42 +609,56 @@ int LinkMode()
             "\" at location \"" << arguments.getArgumentValue("output") << "\"" << std::endl;
 
     // We must load the object files into memory, we also need to take their type into consideration
+    std::vector<struct object_file_load> loads;
     for (std::string file_name : file_names_to_link)
     {
         std::cout << "Loading " << file_name << std::endl;
-        std::string file_ext = getFileExtension(file_name);
+        struct object_file_load load;
+        load.file_name = file_name;
+        load.failed = false;
         try
         {
-            std::shared_ptr<VirtualObjectFormat> obj_format = getObjectFormat(file_ext);
-            std::shared_ptr<Stream> stream = LoadFile(file_name);
-            try
-            {
-                obj_format->read(stream);
-            }
-            catch (Exception ex)
+            load.file_ext = getFileExtension(file_name);
+            // Only the index of an archive is read now, the linker reads the members it needs
+            if (load.file_ext == ARCHIVE_EXTENSION)
             {
-                std::cout << "There was a problem reading from or translating the object stream for object format "
-                        "of type \"" << file_ext << "\"" << ", for input file: \"" << file_name << "\"." <<
-                        " Detailed message: " << ex.getMessage() << std::endl;
-                return ERROR_WITH_OBJECT_FORMAT;
+                std::shared_ptr<Archive> archive = std::shared_ptr<Archive>(new Archive());
+                archive->read(LoadFile(file_name));
+                archives.push_back(archive);
+                continue;
             }
-
-#ifdef DEBUG_MODE
-            // Lets output debugging information as debug mode is enabled
-            debug_virtual_object_format(obj_format);
-#endif
-
-            // Ok we have everything we need let's add the object file to a vector for later processing
-            obj_files.push_back(obj_format);
+            load.obj_format = getObjectFormat(load.file_ext);
         }
         catch (Exception ex)
         {
             std::cout << "Could not load object format of type \"" <<
-                    file_ext << "\" for input file: \"" << file_name << "\"." <<
+                    load.file_ext << "\" for input file: \"" << file_name << "\"." <<
                     " Please make sure a virtual object format exists for the given type." << std::endl <<
                     "Detailed reason for failure: \"" << ex.getMessage() << "\"" << std::endl;
             return ERROR_WITH_OBJECT_FORMAT;
         }
+        loads.push_back(load);
+    }
+
+    // The files are read at the same time but we go through them in the order they were given so linking is always the same
+    LoadObjectFiles(&loads);
+    for (struct object_file_load load : loads)
+    {
+        if (load.failed)
+        {
+            std::cout << "There was a problem reading from or translating the object stream for object format "
+                    "of type \"" << load.file_ext << "\"" << ", for input file: \"" << load.file_name << "\"." <<
+                    " Detailed message: " << load.error_message << std::endl;
+            return ERROR_WITH_OBJECT_FORMAT;
+        }
+
+#ifdef DEBUG_MODE
+        // Lets output debugging information as debug mode is enabled
+        debug_virtual_object_format(load.obj_format);
+#endif
+
+        // Ok we have everything we need let's add the object file to a vector for later processing
+        obj_files.push_back(load.obj_format);
     }
 
     // Now we must load the executable format linker
@@ -532,10 +680,28 @@ int LinkMode()
         linker->addObjectFile(obj_file);
     }
 
+    for (std::shared_ptr<Archive> archive : archives)
+    {
+        linker->addArchive(archive);
+    }
+    linker->setObjectFormatFactory(getObjectFormat);
+
     try
     {
         linker->link();
         std::cout << "Link successful" << std::endl;
+        for (std::string message : linker->getWarnings())
+        {
+            std::cout << "Warning: " << message << std::endl;
+        }
+
+        if (arguments.hasArgument("report"))
+        {
+            for (std::string message : linker->getReport())
+            {
+                std::cout << message << std::endl;
+            }
+        }
     }
     catch (Exception ex)
     {
@@ -556,6 +722,90 @@ int LinkMode()
     return 0;
 }
 
+/* Bundles object files into an archive the linker can pull them from */
+int ArchiveMode()
+{
+    if (!arguments.hasArgument("input"))
+    {
+        std::cout << "You must provide the object files to archive, use -input \"obj1,obj2\"" << std::endl;
+        return PROBLEM_WITH_ARGUMENT;
+    }
+
+    if (!arguments.hasArgument("output"))
+    {
+        std::cout << "You must provide an output file, use -output filename" << std::endl;
+        return PROBLEM_WITH_ARGUMENT;
+    }
+
+    output_file_name = arguments.getArgumentValue("output");
+    std::vector<struct object_file_load> loads;
+    for (std::string file_name : Helper::split(arguments.getArgumentValue("input"), ','))
+    {
+        std::cout << "Loading " << file_name << std::endl;
+        struct object_file_load load;
+        load.file_name = file_name;
+        load.failed = false;
+        try
+        {
+            load.file_ext = getFileExtension(file_name);
+            load.obj_format = getObjectFormat(load.file_ext);
+        }
+        catch (Exception ex)
+        {
+            std::cout << "Could not load object format of type \"" <<
+                    load.file_ext << "\" for input file: \"" << file_name << "\"." <<
+                    " Detailed reason for failure: \"" << ex.getMessage() << "\"" << std::endl;
+            return ERROR_WITH_OBJECT_FORMAT;
+        }
+        loads.push_back(load);
+    }
+
+    // The object files are read so the archive can index the global references each one defines
+    LoadObjectFiles(&loads);
+    Archive archive;
+    for (struct object_file_load load : loads)
+    {
+        if (load.failed)
+        {
+            std::cout << "There was a problem reading the object file: \"" << load.file_name << "\"." <<
+                    " Detailed message: " << load.error_message << std::endl;
+            return ERROR_WITH_OBJECT_FORMAT;
+        }
+
+        // The same global reference may be registered more than once by an object, e.g once for its GLOBAL directive and once for its label
+        std::set<std::string> symbols;
+        for (std::shared_ptr<GLOBAL_REF> global_ref : load.obj_format->getGlobalReferences())
+        {
+            symbols.insert(global_ref->getName());
+        }
+
+        try
+        {
+            archive.addMember(load.file_name, load.file_ext, load.stream, std::vector<std::string>(symbols.begin(), symbols.end()));
+        }
+        catch (Exception ex)
+        {
+            std::cout << "Failed to archive: " << ex.getMessage() << std::endl;
+            return ERROR_WITH_ARCHIVE;
+        }
+    }
+
+    try
+    {
+        Stream archive_stream;
+        archive.write(&archive_stream);
+        WriteFile(output_file_name, &archive_stream);
+    }
+    catch (Exception ex)
+    {
+        std::cout << "Failed to output archive file" << std::endl;
+        return ERROR_WITH_OUTPUT_FILE;
+    }
+
+    std::cout << "Archived " << archive.getTotalMembers() << " object files to \"" << output_file_name << "\"" << std::endl;
+    return 0;
+}
+
 void HelpMenu()
 {
     std::cout << "HELP MENU" << std::endl;
@@ -567,6 +817,16 @@ void HelpMenu()
     std::cout << "To specify an output file: -output \"filename\"" << std::endl;
     std::cout << "To specify a code generator: -codegen \"codegen_name\" e.g -codegen \"8086CodeGen\"" << std::endl;
     std::cout << "To specify an object file to output: -format \"object_format_name\" e.g -format \"omf\"" << std::endl;
+    std::cout << "The native \"cobj\" object format is quicker to write and link than OMF, use OMF for object files other tools must read" << std::endl;
+    std::cout << "To optimize for size rather than speed: -Os" << std::endl;
+    std::cout << "To specify the code size in bytes small loops may be unrolled to: -unroll_budget \"bytes\" e.g -unroll_budget \"128\"" << std::endl;
+    std::cout << "To pass the first arguments of every function in registers unless marked \"__stackcall\": -regcall" << std::endl;
+    std::cout << "To stop a function from being inlined give it the \"__noinline\" attribute e.g \"__noinline uint8 test()\"" << std::endl;
+    std::cout << "To keep a function private to its file give it the \"__static\" attribute, it is then removed if nothing calls it e.g \"__static uint8 test()\"" << std::endl;
+    std::cout << "To lay out global variables and structures without word alignment padding: -packed" << std::endl;
+    std::cout << "To place every function but the first in a segment of its own that the linker can remove if nothing calls it: -function_sections" << std::endl;
+    std::cout << "To place zero initialised globals in a bss segment that takes no space in the binary: -bss_zeroing, the program must then be linked with -bss_zeroing" << std::endl;
+    std::cout << "To report the optimizations made by the compiler: -report" << std::endl;
     std::cout << "-----------------------------------------" << std::endl;
     std::cout << "Full Example: craft -input \"test_file.craft\" -output \"test.omf\" -codegen \"8086CodeGen\" -O -format \"omf\"" << std::endl;
     std::cout << "====================================" << std::endl;
@@ -578,8 +838,22 @@ void HelpMenu()
     std::cout << "To specify an output file: -output \"filename\"" << std::endl;
     std::cout << "To specify a format to link to: -format \"type\" e.g -format \"bin\" for binary files" << std::endl;
     std::cout << "To specify origins for particular segments use: -org_segment_name \"origin\" e.g -org_data \"0x100\" for the data segment to origin at 0x100" << std::endl;
+    std::cout << "To merge identical strings in the \"strings\" segment of all object files: -merge_strings" << std::endl;
+    std::cout << "To zero the bss segment when the program starts: -bss_zeroing, objects compiled with -bss_zeroing must be linked with it too" << std::endl;
+    std::cout << "Function sections that nothing refers to are removed, to keep them: -no_gc_sections" << std::endl;
+    std::cout << "To report the segments removed by the linker: -report" << std::endl;
     std::cout << "-----------------------------------------" << std::endl;
     std::cout << "Full Example: craft -input \"test.omf,test2.omf,test3.omf\" -output \"test.com\" -L -format \"bin\" -org_data \"0x100\"" << std::endl;
+    std::cout << "Archives may be given as input files too, only the object files in them that define something needed are linked e.g -input \"test.omf,stdlib.lib\"" << std::endl;
+    std::cout << "===================================" << std::endl;
+    std::cout << std::endl;
+    std::cout << "For archiving" << std::endl;
+    std::cout << "===================================" << std::endl;
+    std::cout << "First specify -A to state you wish to bundle object files into an archive" << std::endl;
+    std::cout << "To specify input files: -input \"obj1.ext,obj2.ext,obj3.ext\"" << std::endl;
+    std::cout << "To specify an output file: -output \"filename.lib\"" << std::endl;
+    std::cout << "-----------------------------------------" << std::endl;
+    std::cout << "Full Example: craft -input \"string.omf,memory.omf\" -output \"stdlib.lib\" -A" << std::endl;
     std::cout << "===================================" << std::endl;
     std::cout << std::endl;
     std::cout << "Also ensure that you do not use the equal sign while using these options, e.g -input = \"name\" is illegal use -input \"name\"" << std::endl;
@@ -612,9 +886,9 @@ int main(int argc, char** argv)
     }
     
     // Some error checking
-    if (arguments.hasArgument("O") && arguments.hasArgument("L"))
+    if ((arguments.hasArgument("O") + arguments.hasArgument("L") + arguments.hasArgument("A")) > 1)
     {
-        std::cout << "You have specified to produce an output file and also link. This is not yet supported please choose one or the other." << std::endl;
+        std::cout << "You have specified more than one of -O, -L and -A. This is not yet supported please choose one." << std::endl;
         return PROBLEM_WITH_ARGUMENT;
     }
     else if (arguments.hasArgument("L"))
@@ -637,9 +911,14 @@ int main(int argc, char** argv)
         // Ok we are linking object files together to produce an executable file
         return LinkMode();
     }
+    else if (arguments.hasArgument("A"))
+    {
+        // Ok we are bundling object files into an archive
+        return ArchiveMode();
+    }
     else
     {
-        std::cout << "I do not know weather to produce an object file or link to create an executable, please specify either -O or -L" << std::endl;
+        std::cout << "I do not know weather to produce an object file, link to create an executable or create an archive, please specify either -O, -L or -A" << std::endl;
         return PROBLEM_WITH_ARGUMENT;
     }
 
@@ -66,7 +66,7 @@ LDLIBSOPTIONS=../bin/GoblinArgumentParser.dll ../bin/GoblinLibraryLoader.dll ../
 
 ../bin/craft.exe: ${OBJECTFILES}
 	${MKDIR} -p ../bin
-	${LINK.cc} -o ../bin/craft ${OBJECTFILES} ${LDLIBSOPTIONS}
+	${LINK.cc} -o ../bin/craft ${OBJECTFILES} ${LDLIBSOPTIONS} -pthread
 
 ${OBJECTDIR}/main.o: main.cpp
 	${MKDIR} -p ${OBJECTDIR}
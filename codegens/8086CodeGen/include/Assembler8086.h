@@ -318,7 +318,29 @@ enum
     TEST_REG_WITH_IMM_W1,
     
     XCHG_REG_WITH_REG_W0,
-    XCHG_REG_WITH_REG_W1
+    XCHG_REG_WITH_REG_W1,
+
+    // String instructions, "rep" is treated as its own instruction as it is only a prefix
+    REP,
+    CLD,
+    MOVSB,
+    MOVSW,
+    STOSB,
+    STOSW,
+    LODSB,
+    LODSW,
+
+    // Loop instructions, "loop" and "jcxz" are short only
+    LOOP_SHORT,
+    JCXZ_SHORT,
+    INC_REG16,
+    DEC_REG16,
+
+    // Returns and releases the given amount of bytes from the stack
+    RET_IMM16,
+
+    // Jumps to the address held in the given memory location, used for jump tables
+    JMP_MEM16
    
 };
 
@@ -379,8 +401,10 @@ private:
     void gen_oorrrmmm(std::shared_ptr<InstructionBranch> ins_branch, unsigned char def_rrr = -1);
     void gen_imm(INSTRUCTION_INFO info, std::shared_ptr<InstructionBranch> ins_branch);
     void generate_part(std::shared_ptr<Branch> branch);
+    void check_pass_1_offset(std::shared_ptr<OffsetableBranch> branch);
     void generate_instruction(std::shared_ptr<InstructionBranch> instruction_branch);
     void generate_data(std::shared_ptr<DataBranch> data_branch);
+    void generate_data_address(std::string iden_value);
     void generate_segment(std::shared_ptr<SegmentBranch> branch);
 
     inline char bind_modrm(char oo, char rrr, char mmm);
@@ -30,11 +30,21 @@
 #include <deque>
 #include <vector>
 #include <memory>
+#include <map>
+#include <algorithm>
 #include <condition_variable>
 #include "CodeGenerator.h"
 #include "branches.h"
 
 #define POINTER_SIZE 2
+// The amount of arguments passed in registers for functions using the register calling convention, see "__regcall"
+#define REGISTER_CALL_MAX_ARGUMENTS 3
+// Switch statements need at least this many cases before a jump table is considered
+#define SWITCH_JUMP_TABLE_MIN_CASES 4
+// A jump table is only used if it holds no more than this many entries for every case, the rest lead to the default
+#define SWITCH_JUMP_TABLE_MAX_ENTRIES_PER_CASE 2
+// Compare trees stop dividing once this few cases remain and compare them one after the other
+#define SWITCH_COMPARE_TREE_MAX_LEAF_CASES 3
 
 enum
 {
@@ -74,7 +84,6 @@ struct COMPARE_EXPRESSION_DESC
 {
     std::string cmp_exp_true_label_name;
     std::string cmp_exp_false_label_name;
-    std::string cmp_exp_end_label_name;
     std::string cmp_exp_last_logic_operator;
 };
 
@@ -158,7 +167,6 @@ public:
     inline std::string make_unique_label(std::string segment = "code");
     inline std::string build_unique_label();
 
-    void setup_comparing();
     void new_breakable_label(std::shared_ptr<Branch> branch_to_stop_reset);
     void end_breakable_label();
 
@@ -169,10 +177,12 @@ public:
     void end_scope();
 
     std::string make_string(std::shared_ptr<Branch> string_branch);
+    void make_string_pool();
     void make_inline_asm(struct stmt_info* s_info, std::shared_ptr<ASMBranch> asm_branch);
     void make_variable(std::string name, std::string datatype, std::shared_ptr<Branch> value_exp);
     void make_mem_assignment(std::string dest, std::shared_ptr<Branch> value_exp = NULL, bool is_word = false, std::function<void() > assignment_val_processed = NULL);
-    void handle_logical_expression(std::shared_ptr<Branch> exp_branch, struct stmt_info* s_info, bool should_setup = true);
+    void handle_logical_expression(std::shared_ptr<Branch> exp_branch, struct stmt_info* s_info);
+    void make_condition_jump(std::shared_ptr<Branch> exp, struct stmt_info* s_info, bool jump_if, std::string label);
     void make_expression(std::shared_ptr<Branch> exp, struct stmt_info* info, std::function<void() > exp_start_func = NULL, std::function<void() > exp_end_func = NULL);
     void make_expression_part(std::shared_ptr<Branch> exp, std::string register_to_store, struct stmt_info* s_info);
     void make_expression_left(std::shared_ptr<Branch> exp, std::string register_to_store, struct stmt_info* s_info);
@@ -185,17 +195,35 @@ public:
     void make_move_reg_variable(std::string reg_name, std::shared_ptr<VarIdentifierBranch> var_branch, struct stmt_info* s_info);
     void make_move_var_addr_to_reg(struct stmt_info* s_info, std::string reg_name, std::shared_ptr<VarIdentifierBranch> var_branch);
     void make_array_offset_instructions(struct stmt_info* s_info, std::shared_ptr<ArrayIndexBranch> array_branch, int size_p_elem = 1);
-    void make_move_mem_to_mem(VARIABLE_ADDRESS &dest_loc, VARIABLE_ADDRESS &from_loc, int size);
     void make_move_mem_to_mem(std::string dest_loc, std::string from_loc, int size);
+    void make_rep_move(int size);
+    bool is_var_iden_for(std::shared_ptr<Branch> branch, std::shared_ptr<VDEFBranch> vdef_branch);
+    int get_block_elem_size(std::shared_ptr<Branch> branch, std::shared_ptr<VDEFBranch> index_vdef_branch);
+    int get_indexed_elem_size(std::shared_ptr<Branch> branch, std::shared_ptr<VDEFBranch> index_vdef_branch);
+    bool make_block_loop(std::shared_ptr<FORBranch> branch);
+    bool is_cx_preserved(std::shared_ptr<Branch> branch);
+    bool make_counted_loop(std::shared_ptr<FORBranch> branch);
+    void make_scale_register(std::string reg, int size);
+    bool get_induction_step(std::shared_ptr<Branch> branch, std::shared_ptr<VDEFBranch> vdef_branch, int* step);
+    bool is_address_taken(std::shared_ptr<Branch> branch, std::shared_ptr<VDEFBranch> vdef_branch);
+    bool setup_induction_variable(std::shared_ptr<VDEFBranch> vdef_branch, std::shared_ptr<Branch> step_branch, std::vector<std::shared_ptr<Branch>> loop_parts);
+    void make_induction_step();
+    void end_induction_variable();
   
     void handle_struct_access(struct stmt_info* s_info, std::shared_ptr<STRUCTAccessBranch> access_branch);
     std::string make_var_access(struct stmt_info* s_info, std::shared_ptr<VarIdentifierBranch> var_branch, int* data_size = NULL);
-    void make_appendment(std::string target_reg, std::string op, std::string pos);
+    void make_appendment(std::string target_reg, std::string op, std::string old_value);
     void make_var_assignment(std::shared_ptr<Branch> var_branch, std::shared_ptr<Branch> value, std::string op);
     void make_logical_not(std::shared_ptr<LogicalNotBranch> logical_not_branch, std::string register_to_store, struct stmt_info* s_info);
 
     void calculate_scope_size(std::shared_ptr<ScopeBranch> scope_branch);
     void reset_scope_size();
+    void make_stack_reserve(int size);
+    void make_stack_release(int size);
+    bool is_frame_needed(std::shared_ptr<FuncBranch> func_branch);
+    bool has_frame_dependant_branch(std::shared_ptr<Branch> branch);
+    bool is_bx_frame_possible(std::shared_ptr<Branch> branch);
+    struct VARIABLE_ADDRESS get_bx_frame_address(struct VARIABLE_ADDRESS bp_address);
 
     void handle_ptr(struct stmt_info* s_info, std::shared_ptr<PTRBranch> ptr_branch);
     void handle_global_var_def(std::shared_ptr<VDEFBranch> vdef_branch);
@@ -203,17 +231,26 @@ public:
     void handle_function_definition(std::shared_ptr<FuncDefBranch> func_def_branch);
     void handle_function(std::shared_ptr<FuncBranch> func_branch);
     void handle_func_args(std::shared_ptr<Branch> arguments);
+    int get_register_argument_count(std::shared_ptr<FuncDefBranch> func_def_branch);
+    bool make_register_argument_hold(std::shared_ptr<FuncBranch> func_branch, int total_register_args);
+    void make_register_argument_spill(int total_register_args);
+    std::string get_held_argument_register(std::shared_ptr<VDEFBranch> vdef_branch);
     void handle_body(struct stmt_info* s_info, std::shared_ptr<Branch> body);
     void handle_stmt(struct stmt_info* s_info, std::shared_ptr<Branch> branch);
     void handle_function_call(std::shared_ptr<FuncCallBranch> branch);
     void handle_scope_assignment(std::shared_ptr<AssignBranch> assign_branch);
     void handle_func_return(struct stmt_info* s_info, std::shared_ptr<ReturnBranch> return_branch);
-    void handle_compare_expression();
+    int get_func_scope_size_to_release();
+    bool make_tail_call(std::shared_ptr<FuncCallBranch> func_call_branch);
     void handle_scope_variable_declaration(std::shared_ptr<VDEFBranch> branch);
     void compare_single();
     void handle_if_stmt(std::shared_ptr<IFBranch> branch);
     void handle_for_stmt(std::shared_ptr<FORBranch> branch);
     void handle_while_stmt(std::shared_ptr<WhileBranch> branch);
+    void handle_switch_stmt(std::shared_ptr<SwitchBranch> branch);
+    bool is_switch_dense(std::vector<std::pair<unsigned int, std::string>>& cases);
+    void make_switch_jump_table(std::vector<std::pair<unsigned int, std::string>>& cases, std::string default_label);
+    void make_switch_compare_tree(std::vector<std::pair<unsigned int, std::string>>& cases, int start, int end, std::string default_label);
     void handle_break(std::shared_ptr<BreakBranch> branch);
     void handle_continue(std::shared_ptr<ContinueBranch> branch);
     void handle_array_index(struct stmt_info* s_info, std::shared_ptr<ArrayIndexBranch> array_index_branch, int elem_size);
@@ -229,6 +266,11 @@ public:
     // scope_handle_func is deprecated
     void scope_handle_func(struct stmt_info* s_info, struct position_info* pos_info);
     void handle_next_access(struct stmt_info* s_info, struct VARIABLE_ADDRESS* address, std::shared_ptr<VarIdentifierBranch> next_var_iden);
+    bool begin_address_capture();
+    void end_address_capture();
+    bool is_bx_address_load(std::string asm_ins, bool is_first);
+    bool is_bx_preserved_by(std::string asm_ins);
+    struct VARIABLE_ADDRESS get_global_variable_address(int abs_position);
     struct VARIABLE_ADDRESS getASMAddressForVariable(struct stmt_info* s_info, std::shared_ptr<VarIdentifierBranch> root_var_branch, bool to_variable_start_only = false);
     std::string getASMAddressForVariableFormatted(struct stmt_info* s_info, std::shared_ptr<VarIdentifierBranch> root_var_branch, bool to_variable_start_only = false);
 
@@ -242,19 +284,23 @@ public:
     inline bool is_alone_var_to_be_word(std::shared_ptr<VDEFBranch> vdef_branch, bool ignore_pointer = false);
     inline bool is_alone_var_to_be_word(std::shared_ptr<VarIdentifierBranch> var_branch, bool ignore_pointer = false);
 
+    virtual int getVariableAlignment(std::shared_ptr<ScopeBranch> scope_branch, std::shared_ptr<VDEFBranch> vdef_branch);
+    virtual void do_asm(std::string asm_ins, std::string segment = "code");
+    virtual void generate(std::shared_ptr<Tree> tree);
     void generate_global_branch(std::shared_ptr<Branch> branch);
     void assemble(std::string assembly);
 private:
     Compiler* compiler;
     std::vector<std::shared_ptr<Branch>> func_arguments;
     std::vector<std::shared_ptr<VDEFBranch>> global_variables;
+    // Key = position of the global variable relative to zero, value = the global variable
+    std::map<int, std::shared_ptr<VDEFBranch>> global_variable_positions;
     std::vector<std::shared_ptr<VDEFBranch>> scope_variables;
     std::vector<std::shared_ptr<STRUCTBranch>> structures;
     std::shared_ptr<STRUCTBranch> last_structure;
 
     std::string cmp_exp_true_label_name;
     std::string cmp_exp_false_label_name;
-    std::string cmp_exp_end_label_name;
     std::string cmp_exp_last_logic_operator;
     bool cmp_exp_handle_if_all_false_follow_through;
 
@@ -274,6 +320,13 @@ private:
     bool is_cmp_expression;
     bool do_signed;
 
+    // The induction variable of the loop being generated, SI holds it multiplied by the element size (or the address if the base is hoisted)
+    std::shared_ptr<VDEFBranch> induction_vdef;
+    std::shared_ptr<VDEFBranch> induction_base_vdef;
+    std::shared_ptr<Branch> induction_step_branch;
+    int induction_elem_size;
+    int induction_step;
+
 
     std::shared_ptr<VDEFBranch> last_found_var_access_variable;
 
@@ -283,6 +336,44 @@ private:
     // Holds the current function being generated
     std::shared_ptr<FuncBranch> cur_func;
     int cur_func_scope_size;
+    // False if the current function was generated without pushing BP and setting up a stack frame
+    bool cur_func_has_frame;
+    // True if the current function has no frame but addresses its arguments and variables through BX holding a copy of SP
+    bool cur_func_has_bx_frame;
+    // The label just after the current function has set up its frame, self recursive tail calls jump here
+    std::string cur_func_body_label;
+
+    /* Register arguments of the current function that are kept in a register for the whole function rather than spilled to the stack.
+     * Key = the argument, value = the register holding it */
+    std::map<std::shared_ptr<VDEFBranch>, std::string> held_arguments;
+    int total_held_arguments;
+
+    // The amount of functions generated and the amount of those whose stack frame was elided
+    int total_functions;
+    int total_elided_frames;
+    int total_bx_frames;
+
+    /* The instructions that last computed the address held in BX, blank if BX holds nothing we know of.
+     * Variable addresses that would be computed with the exact same instructions can use BX as it is */
+    std::string bx_address;
+    bool is_capturing_address;
+    std::vector<std::string> captured_address_asm;
+    int total_reused_addresses;
+
+    // Key = "CASE" or "DEFAULT" branch, value = the label switch statements jump to for it
+    std::map<std::shared_ptr<Branch>, std::string> switch_labels;
+    /* Jump tables are appended to the data segment once everything is generated, 
+     * this way they do not shift the offsets of the global variables */
+    std::vector<std::string> switch_jump_tables;
+    int total_switches;
+    int total_jump_tables;
+    int total_compare_trees;
+    int total_bss_bytes;
+
+    // Key = string literal, value = the label for it in the "strings" segment
+    std::map<std::string, std::string> string_labels;
+    int total_strings;
+    int total_merged_strings;
 
     std::shared_ptr<StandardScopeBranch> current_scope;
     std::deque<std::shared_ptr<StandardScopeBranch>> current_scopes;
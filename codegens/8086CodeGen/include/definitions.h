@@ -29,7 +29,8 @@ enum
 {
     DATA_BRANCH_TYPE_DATA_BYTE,
     DATA_BRANCH_TYPE_DATA_WORD,
-    DATA_BRANCH_TYPE_DATA_RESERVE_BYTE
+    DATA_BRANCH_TYPE_DATA_RESERVE_BYTE,
+    DATA_BRANCH_TYPE_ALIGN
 };
 
 typedef char DATA_BRANCH_TYPE;
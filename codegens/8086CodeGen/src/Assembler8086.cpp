@@ -80,7 +80,9 @@ unsigned char ins_map[] = {
     0xc1, 0xcd, 0x38, 0x39, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d,
     0x80, 0x81, 0x80, 0x81, 0x8d, 0xd2, 0xd3, 0xd2, 0xd3, 0xf6,
     0xf7, 0xf6, 0xf7, 0x84, 0x85, 0x84, 0x85, 0x84, 0x85, 0xa8,
-    0xa9, 0xf6, 0xf7, 0x86, 0x87
+    0xa9, 0xf6, 0xf7, 0x86, 0x87, 0xf3, 0xfc, 0xa4, 0xa5, 0xaa,
+    0xab, 0xac, 0xad, 0xe2, 0xe3, 0x40, 0x48,
+    0xc2, 0xff
 };
 
 // instruction size excluding OOMMM and OORRRMMM rules that change the size (you should still include the OOMMM and OORRRMMM byte)
@@ -98,7 +100,8 @@ unsigned char ins_sizes[] = {
     3, 2, 2, 2, 2, 2, 2, 2, 2, 3,
     3, 4, 3, 4, 2, 2, 2, 2, 2, 2,
     2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
-    3, 3, 4, 2, 2
+    3, 3, 4, 2, 2, 1, 1, 1, 1, 1,
+    1, 1, 1, 2, 2, 1, 1, 3, 2
 };
 
 
@@ -118,7 +121,8 @@ unsigned char static_rrr[] = {
     3, 0, 0, 0, 0, 0, 0, 0, 0, 0,
     7, 7, 7, 7, 0, 3, 3, 2, 2, 5,
     5, 7, 7, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 4
 };
 
 /* Describes information relating to an instruction 
@@ -263,6 +267,20 @@ INSTRUCTION_INFO ins_info[] = {
     USE_W | HAS_OOMMM |HAS_REG_USE_LEFT | HAS_IMM_USE_RIGHT, // test reg16, imm16
     HAS_OORRRMMM | HAS_REG_USE_LEFT | HAS_REG_USE_RIGHT, // xchg reg8, reg8
     USE_W | HAS_OORRRMMM | HAS_REG_USE_LEFT | HAS_REG_USE_RIGHT, // xchg reg16, reg16
+    NO_PROPERTIES, // rep
+    NO_PROPERTIES, // cld
+    NO_PROPERTIES, // movsb
+    NO_PROPERTIES, // movsw
+    NO_PROPERTIES, // stosb
+    NO_PROPERTIES, // stosw
+    NO_PROPERTIES, // lodsb
+    NO_PROPERTIES, // lodsw
+    HAS_IMM_USE_LEFT | SHORT_POSSIBLE, // loop short imm8
+    HAS_IMM_USE_LEFT | SHORT_POSSIBLE, // jcxz short imm8
+    USE_W | HAS_RRR | HAS_REG_USE_LEFT, // inc reg16
+    USE_W | HAS_RRR | HAS_REG_USE_LEFT, // dec reg16
+    USE_W | HAS_IMM_USE_LEFT, // ret imm16
+    USE_W | HAS_OOMMM, // jmp mem - jumps to the word specified in location
 };
 
 struct ins_syntax_def ins_syntax[] = {
@@ -400,7 +418,22 @@ struct ins_syntax_def ins_syntax[] = {
     "test", TEST_REG_WITH_IMM_W0, REG8_IMM8,
     "test", TEST_REG_WITH_IMM_W1, REG16_IMM16,
     "xchg", XCHG_REG_WITH_REG_W0, REG8_REG8,
-    "xchg", XCHG_REG_WITH_REG_W1, REG16_REG16
+    "xchg", XCHG_REG_WITH_REG_W1, REG16_REG16,
+    "rep", REP, ALONE_ALONE,
+    "cld", CLD, ALONE_ALONE,
+    "movsb", MOVSB, ALONE_ALONE,
+    "movsw", MOVSW, ALONE_ALONE,
+    "stosb", STOSB, ALONE_ALONE,
+    "stosw", STOSW, ALONE_ALONE,
+    "lodsb", LODSB, ALONE_ALONE,
+    "lodsw", LODSW, ALONE_ALONE,
+    "loop", LOOP_SHORT, IMM8_ALONE,
+    "jcxz", JCXZ_SHORT, IMM8_ALONE,
+    "inc", INC_REG16, REG16_ALONE,
+    "dec", DEC_REG16, REG16_ALONE,
+    "ret", RET_IMM16, IMM8_ALONE,
+    "ret", RET_IMM16, IMM16_ALONE,
+    "jmp", JMP_MEM16, MEM16_ALONE
 };
 
 /* Certain instructions have condition codes that specify a particular event.
@@ -429,6 +462,7 @@ Assembler8086::Assembler8086(Compiler* compiler, std::shared_ptr<VirtualObjectFo
     Assembler::addKeyword("db");
     Assembler::addKeyword("dw");
     Assembler::addKeyword("rb");
+    Assembler::addKeyword("align");
 
     Assembler::addRegister("ax");
     Assembler::addRegister("ah");
@@ -483,6 +517,20 @@ Assembler8086::Assembler8086(Compiler* compiler, std::shared_ptr<VirtualObjectFo
     Assembler::addInstruction("cmp");
     Assembler::addInstruction("test");
     Assembler::addInstruction("xchg");
+    /* "rep" is a prefix but we treat it as an instruction of its own, "rep movsw" will be parsed
+     * as two instructions which assemble to the correct bytes */
+    Assembler::addInstruction("rep");
+    Assembler::addInstruction("cld");
+    Assembler::addInstruction("movsb");
+    Assembler::addInstruction("movsw");
+    Assembler::addInstruction("stosb");
+    Assembler::addInstruction("stosw");
+    Assembler::addInstruction("lodsb");
+    Assembler::addInstruction("lodsw");
+    Assembler::addInstruction("loop");
+    Assembler::addInstruction("jcxz");
+    Assembler::addInstruction("inc");
+    Assembler::addInstruction("dec");
 
     this->left = NULL;
     this->right = NULL;
@@ -1001,13 +1049,19 @@ void Assembler8086::parse_data(DATA_BRANCH_TYPE data_branch_type)
         {
             data_branch_type = DATA_BRANCH_TYPE_DATA_RESERVE_BYTE;
         }
+        else if (data_keyword_value == "align")
+        {
+            data_branch_type = DATA_BRANCH_TYPE_ALIGN;
+        }
     }
 
     data_branch->setDataBranchType(data_branch_type);
 
     peek();
-    if (is_peek_type("number") || is_peek_type("string"))
+    if (is_peek_type("number") || is_peek_type("string")
+            || (is_peek_type("identifier") && data_branch_type == DATA_BRANCH_TYPE_DATA_WORD))
     {
+        // Words may also hold the address of a label, this is how jump tables are made
         shift_pop();
         data_branch->setData(getPoppedBranch());
     }
@@ -1095,7 +1149,7 @@ bool Assembler8086::is_next_extern()
 bool Assembler8086::is_next_data()
 {
     peek();
-    return is_peek_keyword("db") || is_peek_keyword("dw") || is_peek_keyword("rb");
+    return is_peek_keyword("db") || is_peek_keyword("dw") || is_peek_keyword("rb") || is_peek_keyword("align");
 }
 
 bool Assembler8086::is_next_newline()
@@ -1211,6 +1265,10 @@ void Assembler8086::pass_1_part(std::shared_ptr<Branch> branch)
     else if (branch->getType() == "INSTRUCTION")
     {
         std::shared_ptr<InstructionBranch> ins_branch = std::dynamic_pointer_cast<InstructionBranch>(branch);
+        if (this->segment->isUninitialized())
+        {
+            throw AssemblerException("Instructions cannot be placed in the uninitialized segment \"" + this->segment->getName() + "\"");
+        }
         // Lets calculate the operand sizes for this instruction
         calculate_operand_sizes_for_instruction(ins_branch);
 
@@ -1247,8 +1305,29 @@ void Assembler8086::pass_1_part(std::shared_ptr<Branch> branch)
             size = total_to_reserve;
             this->cur_offset += size;
         }
+        else if (data_branch_type == DATA_BRANCH_TYPE_ALIGN)
+        {
+            data_branch->setOffset(this->cur_offset);
+            if (d_branch->getType() != "number")
+            {
+                throw Exception("Expecting a \"number\" for assembler data \"align\" keyword but a \"" + d_branch->getType() + "\" keyword was provided");
+            }
+            int alignment = std::stoi(d_branch->getValue());
+            if (alignment <= 0 || (alignment & (alignment - 1)) != 0)
+            {
+                throw AssemblerException("The alignment " + d_branch->getValue() + " is not a power of two");
+            }
+            // We pad up to the next offset that is a multiple of the alignment
+            size = (alignment - (this->cur_offset % alignment)) % alignment;
+            this->cur_offset += size;
+        }
         else
         {
+            if (this->segment->isUninitialized())
+            {
+                throw AssemblerException("Only \"rb\" and \"align\" may be used in the uninitialized segment \"" + this->segment->getName() + "\"");
+            }
+
             do
             {
                 data_branch->setOffset(this->cur_offset);
@@ -1267,7 +1346,7 @@ void Assembler8086::pass_1_part(std::shared_ptr<Branch> branch)
                 }
                 else
                 {
-                    // Ok this must be a number, so just set the size based on weather its a byte or a word
+                    // Ok this must be a number or a label, so just set the size based on weather its a byte or a word
                     size = (data_branch_type == DATA_BRANCH_TYPE_DATA_BYTE ? 1 : 2);
                 }
 
@@ -1451,6 +1530,13 @@ void Assembler8086::get_modrm_from_instruction(std::shared_ptr<InstructionBranch
         {
             *oo = USE_REG_NO_ADDRESSING_MODE;
         }
+        else if (left->isAccessingMemory()
+                && left->hasRegisterBranch()
+                && left->hasImmediate())
+        {
+            // Register based memory with a displacement such as "[_table+bx]", the displacement must follow the modrm
+            *oo = DISPLACEMENT_16BIT_FOLLOW;
+        }
         else
         {
             *oo = DISPLACEMENT_IF_MMM_110;
@@ -1626,6 +1712,11 @@ void Assembler8086::register_segment(std::shared_ptr<SegmentBranch> segment_bran
 {
     std::shared_ptr<VirtualObjectFormat> obj_format = Assembler::getObjectFormat();
     std::shared_ptr<VirtualSegment> segment = obj_format->createSegment(segment_branch->getSegmentNameBranch()->getValue());
+    // The "bss" segment only reserves space so it stores no bytes
+    if (segment->getName() == "bss")
+    {
+        segment->setUninitialized(true);
+    }
     this->segments.push_back(segment);
     this->segment_branches.push_back(segment_branch);
 }
@@ -1784,16 +1875,40 @@ void Assembler8086::generate_part(std::shared_ptr<Branch> branch)
     }
     else if (branch->getType() == "INSTRUCTION")
     {
-        generate_instruction(std::dynamic_pointer_cast<InstructionBranch>(branch));
+        std::shared_ptr<InstructionBranch> ins_branch = std::dynamic_pointer_cast<InstructionBranch>(branch);
+        int start_position = this->sstream->getPosition();
+        check_pass_1_offset(ins_branch);
+        generate_instruction(ins_branch);
+        // Every label offset relies on the size pass 1 calculated so the emitted length must match it exactly
+        int emitted_size = this->sstream->getPosition() - start_position;
+        if (emitted_size != ins_branch->getSize())
+        {
+            throw AssemblerException("The instruction \"" + ins_branch->getInstructionNameBranch()->getValue() + "\" was calculated as " + std::to_string(ins_branch->getSize())
+                                     + " bytes in pass 1 but " + std::to_string(emitted_size) + " bytes were generated");
+        }
     }
     else if (branch->getType() == "DATA")
     {
-        generate_data(std::dynamic_pointer_cast<DataBranch>(branch));
+        std::shared_ptr<DataBranch> data_branch = std::dynamic_pointer_cast<DataBranch>(branch);
+        if (!this->segment->isUninitialized())
+        {
+            check_pass_1_offset(data_branch);
+        }
+        generate_data(data_branch);
     }
 
 
 }
 
+void Assembler8086::check_pass_1_offset(std::shared_ptr<OffsetableBranch> branch)
+{
+    if (this->sstream->getPosition() != branch->getOffset())
+    {
+        throw AssemblerException("Pass 1 placed a branch at offset " + std::to_string(branch->getOffset()) + " in segment \"" + this->segment->getName()
+                                 + "\" but it is being generated at offset " + std::to_string(this->sstream->getPosition()));
+    }
+}
+
 void Assembler8086::generate_instruction(std::shared_ptr<InstructionBranch> instruction_branch)
 {
     std::string ins_name = instruction_branch->getInstructionNameBranch()->getValue();
@@ -1851,12 +1966,32 @@ void Assembler8086::generate_data(std::shared_ptr<DataBranch> data_branch)
     }
     else if (data_branch_type == DATA_BRANCH_TYPE_DATA_RESERVE_BYTE)
     {
-        // Ok we are reserving bytes here so we should just write NULL's for how many bytes their are to reserve
-        int total_to_null = std::stoi(d_branch->getValue());
-        for (int i = 0; i < total_to_null; i++)
+        // Ok we are reserving bytes here, the segment writes NULL's for them unless it is uninitialized
+        segment->reserve(std::stoi(d_branch->getValue()));
+    }
+    else if (data_branch_type == DATA_BRANCH_TYPE_ALIGN)
+    {
+        /* Pad until we are on the alignment, code is padded with "nop" should it be executed.
+         * The segment must then be placed on at least this alignment for the padding to mean anything */
+        int alignment = std::stoi(d_branch->getValue());
+        if (segment->isUninitialized())
         {
-            this->sstream->write8(0);
+            segment->reserve((alignment - (segment->getSize() % alignment)) % alignment);
         }
+        else
+        {
+            unsigned char padding = (segment->getName() == "code" || segment->isFunctionSection() ? 0x90 : 0);
+            while (this->sstream->getPosition() % alignment != 0)
+            {
+                this->sstream->write8(padding);
+            }
+        }
+        segment->setAlignment(std::max(segment->getAlignment(), alignment));
+    }
+    else if (d_branch->getType() == "identifier")
+    {
+        // This data is the address of a label so write its offset and let the linker fix it up
+        generate_data_address(d_branch->getValue());
     }
     else
     {
@@ -1871,6 +2006,31 @@ void Assembler8086::generate_data(std::shared_ptr<DataBranch> data_branch)
     }
 }
 
+void Assembler8086::generate_data_address(std::string iden_value)
+{
+    int cur_address = sstream->getPosition();
+    IDENTIFIER_TYPE iden_type = get_identifier_type(iden_value);
+    if (iden_type == IDENTIFIER_TYPE_LABEL)
+    {
+        this->sstream->write16(get_label_offset(iden_value));
+        // As with instructions we only register fixups for labels outside of our own segment
+        std::shared_ptr<VirtualSegment> target_segment = get_virtual_segment_for_label(iden_value);
+        if (segment != target_segment)
+        {
+            segment->register_fixup_target_segment(FIXUP_TYPE_SEGMENT, target_segment, cur_address, FIXUP_16BIT);
+        }
+    }
+    else if (iden_type == IDENTIFIER_TYPE_EXTERN)
+    {
+        this->sstream->write16(0);
+        segment->register_fixup_target_extern(FIXUP_TYPE_SEGMENT, iden_value, cur_address, FIXUP_16BIT);
+    }
+    else
+    {
+        throw AssemblerException("Only labels and externs may have their address taken by data, \"" + iden_value + "\" is neither");
+    }
+}
+
 char Assembler8086::bind_modrm(char oo, char rrr, char mmm)
 {
     return (oo << 6 | rrr << 3 | mmm);
@@ -2795,4 +2955,4 @@ bool Assembler8086::is_reg_16_bit(std::string _register)
 void Assembler8086::ins_info_except()
 {
     throw AssemblerException("Improperly formatted ins_info array for instruction type: " + std::to_string(cur_ins_type));
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -27,6 +27,16 @@
 #include "CodeGen8086.h"
 #include "Assembler8086.h"
 
+// The registers that the register calling convention passes its arguments in, in argument order
+const std::string register_call_registers[REGISTER_CALL_MAX_ARGUMENTS] = {
+    "ax", "dx", "cx"
+};
+
+// The registers that register arguments can be held in for the whole of a function, in argument order
+const std::string held_argument_registers[] = {
+    "si", "di"
+};
+
 CodeGen8086::CodeGen8086(Compiler* compiler, std::shared_ptr<VirtualObjectFormat> object_format) : CodeGenerator(compiler, object_format, "8086 CodeGenerator", POINTER_SIZE)
 {
     this->compiler = compiler;
@@ -38,14 +48,28 @@ CodeGen8086::CodeGen8086(Compiler* compiler, std::shared_ptr<VirtualObjectFormat
     this->last_found_var_access_variable = NULL;
     this->cur_func = NULL;
     this->cur_func_scope_size = 0;
+    this->cur_func_has_frame = true;
+    this->cur_func_has_bx_frame = false;
+    this->total_functions = 0;
+    this->total_elided_frames = 0;
+    this->total_bx_frames = 0;
+    this->total_held_arguments = 0;
+    this->bx_address = "";
+    this->is_capturing_address = false;
+    this->total_reused_addresses = 0;
+    this->total_switches = 0;
+    this->total_jump_tables = 0;
+    this->total_compare_trees = 0;
+    this->total_bss_bytes = 0;
+    this->total_strings = 0;
+    this->total_merged_strings = 0;
     this->breakable_label = "";
     this->continue_label = "";
 
     this->breakable_branch_to_stop_reset = NULL;
     this->continue_branch_to_stop_reset = NULL;
 
-    // Setup a default label on the data segment for us to offset from for global variables
-    make_label("data", "data");
+    end_induction_variable();
 
     // Allow the data types
     getCompiler()->getSemanticValidator()->allow_data_type("uint8");
@@ -85,18 +109,6 @@ std::string CodeGen8086::build_unique_label()
     return "_u" + label_name;
 }
 
-void CodeGen8086::setup_comparing()
-{
-    if (is_cmp_expression)
-    {
-        throw Exception("Already comparing, handle the previous one.", "void CodeGen8086::setup_comparing()");
-    }
-    this->cmp_exp_false_label_name = build_unique_label();
-    this->cmp_exp_end_label_name = build_unique_label();
-    this->cmp_exp_true_label_name = build_unique_label();
-    is_cmp_expression = true;
-}
-
 void CodeGen8086::new_breakable_label(std::shared_ptr<Branch> branch_to_stop_reset)
 {
     // Save what is currently there if any
@@ -215,14 +227,86 @@ std::string CodeGen8086::make_unique_label(std::string segment)
 
 std::string CodeGen8086::make_string(std::shared_ptr<Branch> string_branch)
 {
+    this->total_strings++;
+
+    // Identical strings share the same label, the strings themselves are written once everything is generated
     std::string str = string_branch->getValue();
-    // We escape any quotes in the string as the assembler will see it as terminating the string
-    str = Helper::str_replace(str, "'", "\\'");
-    std::string label_name = make_unique_label("data");
-    do_asm("db '" + str + "', 0", "data");
+    std::map<std::string, std::string>::iterator it = this->string_labels.find(str);
+    if (it != this->string_labels.end())
+    {
+        return it->second;
+    }
+
+    std::string label_name = build_unique_label();
+    this->string_labels[str] = label_name;
     return label_name;
 }
 
+void CodeGen8086::make_string_pool()
+{
+    /* Strings that are the end of a longer string are placed inside of the longer string e.g "error" in "fatal error",
+     * we go from the longest strings to the shortest so that every string we check against already holds its own place */
+    std::vector<std::string> strings;
+    for (std::pair<std::string, std::string> string_label : this->string_labels)
+    {
+        strings.push_back(string_label.first);
+    }
+
+    std::stable_sort(strings.begin(), strings.end(), [](const std::string& a, const std::string& b) -> bool
+    {
+        return a.length() > b.length();
+    });
+
+    // Key = string, value = the strings that are placed inside of it, longest first
+    std::map<std::string, std::vector < std::string>> suffixes;
+    std::vector<std::string> pooled_strings;
+    for (std::string str : strings)
+    {
+        bool is_suffix = false;
+        for (std::string pooled_str : pooled_strings)
+        {
+            if (pooled_str.compare(pooled_str.length() - str.length(), str.length(), str) == 0)
+            {
+                suffixes[pooled_str].push_back(str);
+                this->total_merged_strings++;
+                is_suffix = true;
+                break;
+            }
+        }
+
+        if (!is_suffix)
+        {
+            pooled_strings.push_back(str);
+        }
+    }
+
+    for (std::string pooled_str : pooled_strings)
+    {
+        make_exact_label(this->string_labels[pooled_str], "strings");
+
+        // Write the string in pieces so that its suffixes can have their labels between them
+        int pos = 0;
+        for (std::string suffix : suffixes[pooled_str])
+        {
+            int suffix_pos = pooled_str.length() - suffix.length();
+            // We escape any quotes in the string as the assembler will see it as terminating the string
+            do_asm("db '" + Helper::str_replace(pooled_str.substr(pos, suffix_pos - pos), "'", "\\'") + "'", "strings");
+            make_exact_label(this->string_labels[suffix], "strings");
+            pos = suffix_pos;
+        }
+
+        std::string remaining = pooled_str.substr(pos);
+        if (remaining.empty())
+        {
+            do_asm("db 0", "strings");
+        }
+        else
+        {
+            do_asm("db '" + Helper::str_replace(remaining, "'", "\\'") + "', 0", "strings");
+        }
+    }
+}
+
 // The only supported inline assembly arguments are numbers and variables, you cannot use pointers either.
 
 void CodeGen8086::make_inline_asm(struct stmt_info* s_info, std::shared_ptr<ASMBranch> asm_branch)
@@ -293,43 +377,84 @@ void CodeGen8086::make_mem_assignment(std::string dest, std::shared_ptr<Branch>
     }
 }
 
-void CodeGen8086::handle_logical_expression(std::shared_ptr<Branch> exp_branch, struct stmt_info* s_info, bool should_setup)
+void CodeGen8086::handle_logical_expression(std::shared_ptr<Branch> exp_branch, struct stmt_info* s_info)
 {
-    std::shared_ptr<Branch> left = exp_branch->getFirstChild();
-    std::shared_ptr<Branch> right = exp_branch->getSecondChild();
-    std::string op = exp_branch->getValue();
+    /* We only get here when the result of a compare or logical expression is actually used as a value e.g. "a = b == c;"
+     * so we must materialise a zero or one into the AX register. Statements such as "IF" branch on the expression directly using make_condition_jump */
+    std::string false_label = build_unique_label();
+    std::string end_label = build_unique_label();
 
-    this->cmp_exp_last_logic_operator = exp_branch->getValue();
+    make_condition_jump(exp_branch, s_info, false, false_label);
+    do_asm("mov ax, 1");
+    do_asm("jmp " + end_label);
+    make_exact_label(false_label);
+    do_asm("mov ax, 0");
+    make_exact_label(end_label);
+}
 
-    bool should_handle = false;
-    if (!this->is_cmp_expression)
+void CodeGen8086::make_condition_jump(std::shared_ptr<Branch> exp, struct stmt_info* s_info, bool jump_if, std::string label)
+{
+    std::string op = exp->getValue();
+    if (exp->getType() == "E" && compiler->isLogicalOperator(op))
     {
-        setup_comparing();
-        should_handle = true;
+        std::shared_ptr<Branch> left = exp->getFirstChild();
+        std::shared_ptr<Branch> right = exp->getSecondChild();
+        if ((op == "&&") != jump_if)
+        {
+            /* "&&" jumping when false or "||" jumping when true, either side alone decides the result
+             * so both sides can jump straight to the label */
+            make_condition_jump(left, s_info, jump_if, label);
+            make_condition_jump(right, s_info, jump_if, label);
+        }
+        else
+        {
+            /* "&&" jumping when true or "||" jumping when false, the left side can only decide the opposite result
+             * so when it does we skip over the right side entirely */
+            std::string skip_label = build_unique_label();
+            make_condition_jump(left, s_info, !jump_if, skip_label);
+            make_condition_jump(right, s_info, jump_if, label);
+            make_exact_label(skip_label);
+        }
     }
-
-    make_expression(left, s_info);
-    make_expression(right, s_info);
-
-    // Due to the way the assembly is generated, if the operator is "&&" we should do a logical jump to the true label
-    if (op == "&&")
+    else if (exp->getType() == "E" && compiler->isCompareOperator(op))
     {
-        do_asm("jmp " + this->cmp_exp_true_label_name);
+        /* make_compare_instruction jumps to the false label when the last logic operator is nothing or "&&" 
+         * and to the true label when it is "||", so point the one we want at our label */
+        this->is_cmp_expression = true;
+        if (jump_if)
+        {
+            this->cmp_exp_last_logic_operator = "||";
+            this->cmp_exp_true_label_name = label;
+        }
+        else
+        {
+            this->cmp_exp_last_logic_operator = "";
+            this->cmp_exp_false_label_name = label;
+        }
+        make_expression(exp, s_info);
+        this->is_cmp_expression = false;
+        this->cmp_exp_last_logic_operator = "";
     }
-
-    if (should_handle)
+    else if (exp->getType() == "LOGICAL_NOT")
     {
-        // Handle any compare expression if any
-        make_exact_label(this->cmp_exp_false_label_name);
-        do_asm("mov ax, 0");
-        do_asm("jmp " + this->cmp_exp_end_label_name);
-        make_exact_label(this->cmp_exp_true_label_name);
-        do_asm("mov ax, 1");
-        make_exact_label(this->cmp_exp_end_label_name);
-        this->cmp_exp_last_logic_operator = "";
-        this->is_cmp_expression = false;
+        // "!x" just inverts the condition we jump on, no need to calculate anything
+        std::shared_ptr<LogicalNotBranch> logical_not_branch = std::dynamic_pointer_cast<LogicalNotBranch>(exp);
+        make_condition_jump(logical_not_branch->getSubjectBranch(), s_info, !jump_if, label);
+    }
+    else
+    {
+        // This is a plain value such as "if(x)" so it is true when it is not zero
+        make_expression(exp, s_info);
+        do_asm("cmp ax, 0");
+        if (jump_if)
+        {
+            do_asm("jne " + label);
+        }
+        else
+        {
+            do_asm("je " + label);
+        }
     }
-
 }
 
 void CodeGen8086::make_expression(std::shared_ptr<Branch> exp, struct stmt_info* s_info, std::function<void() > exp_start_func, std::function<void() > exp_end_func)
@@ -345,19 +470,20 @@ void CodeGen8086::make_expression(std::shared_ptr<Branch> exp, struct stmt_info*
         exp_start_func();
     }
 
-    if (getCompiler()->isCompareOperator(op))
-    {
-        s_info->exp_info.StartCompareExpression();
-    }
-
-    /* In cases where this happens "a && b" have no operators of there own
- so we need to make the compare instruction ourself, we will check if the variable is above zero.*/
-    if (compiler->isLogicalOperator(exp->getValue()))
+    /* Compare and logical expressions that are not part of a condition being jumped on are values,
+     * e.g. "a = b == c;" so we must materialise them */
+    if (exp->getType() == "E" && !this->is_cmp_expression &&
+            (compiler->isLogicalOperator(op) || compiler->isCompareOperator(op)))
     {
         handle_logical_expression(exp, s_info);
     }
     else
     {
+        if (getCompiler()->isCompareOperator(op))
+        {
+            s_info->exp_info.StartCompareExpression();
+        }
+
         if (exp->getType() != "E")
         {
             make_expression_left(exp, "ax", s_info);
@@ -367,6 +493,15 @@ void CodeGen8086::make_expression(std::shared_ptr<Branch> exp, struct stmt_info*
             left = exp->getFirstChild();
             right = exp->getSecondChild();
 
+            /* The operands of a compare are always values, any compares nested inside of them must be materialised.
+             * We must also keep hold of the labels we are going to jump to as the operands may use their own */
+            bool is_cmp_expression = this->is_cmp_expression;
+            struct COMPARE_EXPRESSION_DESC cmp_desc;
+            cmp_desc.cmp_exp_true_label_name = this->cmp_exp_true_label_name;
+            cmp_desc.cmp_exp_false_label_name = this->cmp_exp_false_label_name;
+            cmp_desc.cmp_exp_last_logic_operator = this->cmp_exp_last_logic_operator;
+            this->is_cmp_expression = false;
+
             if (left->getType() == "E")
             {
                 make_expression(left, s_info, NULL, NULL);
@@ -404,15 +539,10 @@ void CodeGen8086::make_expression(std::shared_ptr<Branch> exp, struct stmt_info*
                 do_asm("pop cx");
             }
 
-
-            if (compiler->isCompareOperator(op))
-            {
-                // Setup compare labels
-                if (!this->is_cmp_expression)
-                {
-                    setup_comparing();
-                }
-            }
+            this->is_cmp_expression = is_cmp_expression;
+            this->cmp_exp_true_label_name = cmp_desc.cmp_exp_true_label_name;
+            this->cmp_exp_false_label_name = cmp_desc.cmp_exp_false_label_name;
+            this->cmp_exp_last_logic_operator = cmp_desc.cmp_exp_last_logic_operator;
 
             std::string left_reg = "ax";
             std::string right_reg = "cx";
@@ -868,6 +998,13 @@ void CodeGen8086::make_move_reg_variable(std::string reg, std::shared_ptr<VarIde
         this->do_signed = true;
     }
 
+    std::string held_reg = get_held_argument_register(vdef_branch);
+    if (held_reg != "")
+    {
+        do_asm("mov " + reg + ", " + held_reg);
+        return;
+    }
+
     int data_size;
     std::string pos = make_var_access(s_info, var_branch, &data_size);
 
@@ -912,183 +1049,984 @@ void CodeGen8086::make_array_offset_instructions(struct stmt_info* s_info, std::
         }
     }
 
-    if (size_p_elem == 2)
+    make_scale_register("ax", size_p_elem);
+}
+
+void CodeGen8086::make_move_mem_to_mem(std::string dest_loc, std::string from_loc, int size)
+{
+    do_asm("; Moving memory at address " + from_loc + " to " + dest_loc + ", size: " + std::to_string(size));
+    // SI may be holding an induction variable for the loop we are in, SI and DI may also be holding arguments
+    bool preserve_si = this->induction_vdef != NULL || !this->held_arguments.empty();
+    bool preserve_di = this->held_arguments.size() > 1;
+    if (preserve_si)
     {
-        do_asm("shl ax, 1");
+        do_asm("push si");
     }
-    else if (size_p_elem > 2)
+    if (preserve_di)
     {
-        do_asm("mov cx, " + std::to_string(size_p_elem));
-        do_asm("mul cx");
+        do_asm("push di");
     }
-}
-
-void CodeGen8086::make_move_mem_to_mem(VARIABLE_ADDRESS &dest_loc, VARIABLE_ADDRESS &from_loc, int size)
-{
-    std::string continue_lbl_name;
-    do_asm("mov si, " + from_loc.segment);
-    if (from_loc.op == "+")
+    do_asm("lea si, [" + from_loc + "]");
+    do_asm("lea di, [" + dest_loc + "]");
+    make_rep_move(size);
+    if (preserve_di)
     {
-        do_asm("add si, " + std::to_string(from_loc.offset));
+        do_asm("pop di");
     }
-    else if (from_loc.op == "-")
+    if (preserve_si)
     {
-        do_asm("sub si, " + std::to_string(from_loc.offset));
+        do_asm("pop si");
     }
+}
 
-    do_asm("mov di, " + dest_loc.segment);
-    if (dest_loc.op == "+")
+void CodeGen8086::make_rep_move(int size)
+{
+    /* SI and DI must already be setup, we move a word at a time and then the odd byte if there is one.
+     * This code generator does not use segments so ES is expected to be the same as DS */
+    do_asm("cld");
+    if (size / 2 > 0)
     {
-        do_asm("add si, " + std::to_string(dest_loc.offset));
+        do_asm("mov cx, " + std::to_string(size / 2));
+        do_asm("rep movsw");
     }
-    else if (dest_loc.op == "-")
+
+    if (size % 2 != 0)
     {
-        do_asm("sub si, " + std::to_string(dest_loc.offset));
+        do_asm("movsb");
     }
-
-    do_asm("mov cx, " + std::to_string(size));
-    continue_lbl_name = make_unique_label();
-    do_asm("lodsb");
-    do_asm("stosb");
-    do_asm("loop " + continue_lbl_name);
 }
 
-void CodeGen8086::make_move_mem_to_mem(std::string dest_loc, std::string from_loc, int size)
+bool CodeGen8086::is_var_iden_for(std::shared_ptr<Branch> branch, std::shared_ptr<VDEFBranch> vdef_branch)
 {
-    do_asm("; Moving memory at address " + from_loc + " to " + dest_loc + ", size: " + std::to_string(size));
-    std::string continue_lbl_name;
-    do_asm("lea si, " + from_loc);
-    do_asm("lea di, " + dest_loc);
-    do_asm("mov cx, " + std::to_string(size));
-    continue_lbl_name = make_unique_label();
-    do_asm("lodsb");
-    do_asm("stosb");
-    do_asm("loop " + continue_lbl_name);
+    if (branch->getType() != "VAR_IDENTIFIER")
+    {
+        return false;
+    }
+
+    std::shared_ptr<VarIdentifierBranch> var_iden_branch = std::dynamic_pointer_cast<VarIdentifierBranch>(branch);
+    return var_iden_branch->isVariableAlone() && var_iden_branch->getVariableDefinitionBranch() == vdef_branch;
 }
 
-void CodeGen8086::handle_struct_access(struct stmt_info* s_info, std::shared_ptr<STRUCTAccessBranch> struct_access_branch)
+int CodeGen8086::get_block_elem_size(std::shared_ptr<Branch> branch, std::shared_ptr<VDEFBranch> index_vdef_branch)
 {
-    std::string pos = std::to_string(struct_access_branch->getVarIdentifierBranch()->getVariableDefinitionBranch(true)->getPositionRelScope());
-    do_asm("mov bx, [bx+" + pos + "]");
+    // String instructions can only move bytes or words
+    int size = get_indexed_elem_size(branch, index_vdef_branch);
+    if (size != 1 && size != 2)
+    {
+        return 0;
+    }
+
+    return size;
 }
 
-std::string CodeGen8086::make_var_access(struct stmt_info* s_info, std::shared_ptr<VarIdentifierBranch> var_branch, int* data_size)
+int CodeGen8086::get_indexed_elem_size(std::shared_ptr<Branch> branch, std::shared_ptr<VDEFBranch> index_vdef_branch)
 {
-    std::string pos = "";
-    pos = getASMAddressForVariableFormatted(s_info, var_branch);
-    if (data_size != NULL)
+    /* Returns the element size when the branch is in the form "x[i]" where "i" is the index variable provided
+     * and "x" is either a one dimensional array or a pointer, otherwise zero is returned */
+    if (branch->getType() != "VAR_IDENTIFIER")
     {
-        std::shared_ptr<VDEFBranch> vdef_branch = var_branch->getVariableDefinitionBranch();
-        // Expressions should use a lower register for compare expressions if this variable fits into a byte
-        if (vdef_branch->getDataTypeBranch()->getDataTypeSize() == 1)
-        {
-            if (s_info->exp_info.last_compare_exp_info != NULL)
-            {
-                s_info->exp_info.last_compare_exp_info->use_low_reg = true;
-            }
-        }
+        return 0;
+    }
 
-        bool no_pointer = false;
-        /*
-         * When accessing pointers with an array index whose definition has no array index
-         * then we should get the size as if it was not a pointer as we are accessing an array pointed to by a pointer such as a character
-         * array, e.g
-         * uint8* message = "Hello World";
-         * return message[3];
-         */
-        if (var_branch->getFinalVarIdentifierBranch()->hasRootArrayIndexBranch() && vdef_branch->isPointer() && !vdef_branch->getVariableIdentifierBranch()->hasRootArrayIndexBranch())
-        {
-            no_pointer = true;
-        }
-        else if (s_info->is_child_of_pointer)
-        {
-            /*
-             * It is also possible that you could be accessing something as a pointer and depending on the depth will determine the data size.
-             * For example:
-             * uint8 a = 50;
-             * uint8* ptr = &a;
-             * uint8** pptr = &ptr;
-             * 
-             * return *ptr - Data size is one byte
-             * return *pptr - Data size is two bytes
-             * return **pptr - Data size is one byte as we are getting the value of "a"
-             * 
-             * The algorithm for this is quite simple essentially if the pointer depth is equal to the pointer depth
-             * of the pointer variable then we should get the size as if its not a pointer.
-             * If it is not equal then it means it is accessing another address so it must be the size of a pointer.
-             */
+    std::shared_ptr<VarIdentifierBranch> var_iden_branch = std::dynamic_pointer_cast<VarIdentifierBranch>(branch);
+    if (var_iden_branch->hasStructureAccessBranch()
+            || !var_iden_branch->hasRootArrayIndexBranch())
+    {
+        return 0;
+    }
 
-            int vdef_pointer_depth = vdef_branch->getPointerDepth();
-            if (vdef_pointer_depth == s_info->pointer_your_child_of->getPointerDepth())
-            {
-                no_pointer = true;
-            }
+    std::shared_ptr<ArrayIndexBranch> array_index_branch = var_iden_branch->getRootArrayIndexBranch();
+    if (array_index_branch->hasNextArrayIndexBranch()
+            || !is_var_iden_for(array_index_branch->getValueBranch(), index_vdef_branch))
+    {
+        return 0;
+    }
+
+    int size = 0;
+    std::shared_ptr<VDEFBranch> vdef_branch = var_iden_branch->getVariableDefinitionBranch();
+    std::shared_ptr<VarIdentifierBranch> vdef_var_iden_branch = vdef_branch->getVariableIdentifierBranch();
+    if (vdef_var_iden_branch->hasRootArrayIndexBranch())
+    {
+        if (!vdef_var_iden_branch->getRootArrayIndexBranch()->hasNextArrayIndexBranch())
+        {
+            size = vdef_branch->getDataTypeBranch()->getDataTypeSize();
         }
-        *data_size = var_branch->getVariableDefinitionBranch()->getDataTypeBranch()->getDataTypeSize(no_pointer);
     }
-    return pos;
+    else if (vdef_branch->isPointer() && vdef_branch->getPointerDepth() == 1)
+    {
+        size = vdef_branch->getDataTypeBranch()->getDataTypeSize(true);
+    }
+
+    return size;
 }
 
-void CodeGen8086::make_appendment(std::string target_reg, std::string op, std::string pos)
+bool CodeGen8086::make_block_loop(std::shared_ptr<FORBranch> branch)
 {
-    if (target_reg == "ax" || target_reg == "cx")
+    /* Recognises simple fill and copy loops such as:
+     * for (uint8 i = 0; i < size; i = i + 1) { ptr[i] = 0; }
+     * for (uint8 i = 0; i < size; i += 1) { dst[i] = src[i]; }
+     * and generates them as a single "rep stos" or "rep movs" rather than looping an element at a time.
+     * If the loop is not one of these then false is returned and nothing is generated */
+    std::shared_ptr<Branch> init_branch = branch->getInitBranch();
+    std::shared_ptr<Branch> cond_branch = branch->getCondBranch();
+    std::shared_ptr<Branch> loop_branch = branch->getLoopBranch();
+    std::shared_ptr<Branch> body_branch = branch->getBodyBranch();
+
+    // The index variable must be declared by the loop so nothing else can see it once we are done
+    if (init_branch->getType() != "V_DEF")
     {
-        throw Exception("It is not possible to use the ax or cx register", "void CodeGen8086::make_appendment(std::string target_reg, std::string op, std::string pos)");
+        return false;
     }
 
-    // Load the old value
-    do_asm("mov " + target_reg + ", [" + pos + "]");
-    if (op == "+=")
+    // The string instructions need SI and DI for themselves
+    if (!this->held_arguments.empty())
     {
-        do_asm("add " + target_reg + ", ax");
+        return false;
     }
-    else if (op == "-=")
+
+    std::shared_ptr<VDEFBranch> index_vdef_branch = std::dynamic_pointer_cast<VDEFBranch>(init_branch);
+    if (!index_vdef_branch->hasValueExpBranch()
+            || index_vdef_branch->isPointer()
+            || index_vdef_branch->getVariableIdentifierBranch()->hasRootArrayIndexBranch())
     {
-        do_asm("sub " + target_reg + ", ax");
+        return false;
     }
-    else if (op == "*=" || op == "/=" || op == "%=")
+
+    // The condition must be "i < bound" where the bound is a number or another variable
+    if (cond_branch->getType() != "E"
+            || cond_branch->getValue() != "<"
+            || !is_var_iden_for(cond_branch->getFirstChild(), index_vdef_branch))
     {
-        bool using_cx = false;
-        std::string old_target_reg = target_reg;
-        if (target_reg == "dx")
+        return false;
+    }
+
+    std::shared_ptr<Branch> bound_branch = cond_branch->getSecondChild();
+    if (bound_branch->getType() != "number"
+            && (bound_branch->getType() != "VAR_IDENTIFIER"
+            || !std::dynamic_pointer_cast<VarIdentifierBranch>(bound_branch)->isVariableAlone()
+            || is_var_iden_for(bound_branch, index_vdef_branch)))
+    {
+        return false;
+    }
+
+    // The loop must be "i = i + 1" or "i += 1"
+    if (loop_branch->getType() != "ASSIGN")
+    {
+        return false;
+    }
+
+    std::shared_ptr<AssignBranch> loop_assign_branch = std::dynamic_pointer_cast<AssignBranch>(loop_branch);
+    std::shared_ptr<Branch> loop_value_branch = loop_assign_branch->getValueBranch();
+    if (!is_var_iden_for(loop_assign_branch->getVariableToAssignBranch(), index_vdef_branch))
+    {
+        return false;
+    }
+
+    if (loop_assign_branch->getOperator() == "+=")
+    {
+        if (loop_value_branch->getType() != "number" || loop_value_branch->getValue() != "1")
         {
-            // Multiplication, division and modulas use the DX register so we cannot use it
-            // Save CX
-            do_asm("push cx");
-            target_reg = "cx";
-            using_cx = true;
+            return false;
+        }
+    }
+    else if (loop_assign_branch->getOperator() == "=")
+    {
+        if (loop_value_branch->getType() != "E" || loop_value_branch->getValue() != "+")
+        {
+            return false;
         }
 
-        // We must move the old target register to the CX register as we will perform operations on it
-        do_asm("mov cx, " + old_target_reg);
-        
-        /* Now we must exchange CX and AX as AX contains the operand, e.g a += 5;. AX contains 5 we want to perform
-         * var = var * new_value; not var = new_value * var
-         */
-        do_asm("xchg ax, cx");
-        
-        // We must blank DX as the following instructions perform like this DX:AX operator operand
-        do_asm("xor dx, dx");
+        std::shared_ptr<Branch> left = loop_value_branch->getFirstChild();
+        std::shared_ptr<Branch> right = loop_value_branch->getSecondChild();
+        if (!(is_var_iden_for(left, index_vdef_branch) && right->getType() == "number" && right->getValue() == "1")
+                && !(is_var_iden_for(right, index_vdef_branch) && left->getType() == "number" && left->getValue() == "1"))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        return false;
+    }
 
-        if (op == "/=")
+    // The body must be a single "x[i] = value" or "x[i] = y[i]" assignment
+    if (body_branch->getChildren().size() != 1
+            || body_branch->getFirstChild()->getType() != "ASSIGN")
+    {
+        return false;
+    }
+
+    std::shared_ptr<AssignBranch> assign_branch = std::dynamic_pointer_cast<AssignBranch>(body_branch->getFirstChild());
+    std::shared_ptr<Branch> dest_branch = assign_branch->getVariableToAssignBranch();
+    std::shared_ptr<Branch> value_branch = assign_branch->getValueBranch();
+    if (assign_branch->getOperator() != "=")
+    {
+        return false;
+    }
+
+    int elem_size = get_block_elem_size(dest_branch, index_vdef_branch);
+    if (elem_size == 0)
+    {
+        return false;
+    }
+
+    std::shared_ptr<VDEFBranch> dest_vdef_branch = std::dynamic_pointer_cast<VarIdentifierBranch>(dest_branch)->getVariableDefinitionBranch();
+    bool is_copy = false;
+    if (value_branch->getType() == "VAR_IDENTIFIER")
+    {
+        std::shared_ptr<VarIdentifierBranch> value_var_iden_branch = std::dynamic_pointer_cast<VarIdentifierBranch>(value_branch);
+        if (value_var_iden_branch->isVariableAlone())
         {
-            if (do_signed)
-            {
-                do_asm("idiv " + target_reg);
-            }
-            else
+            // Filling with the value of a variable, it must not change while we are filling
+            if (value_var_iden_branch->getVariableDefinitionBranch() == index_vdef_branch
+                    || value_var_iden_branch->getVariableDefinitionBranch() == dest_vdef_branch)
             {
-                do_asm("div " + target_reg);
+                return false;
             }
-
-            if (!is_gen_reg_16_bit(target_reg))
+        }
+        else
+        {
+            // Copying from another array of the same element size
+            if (get_block_elem_size(value_branch, index_vdef_branch) != elem_size)
             {
-                // AH contains remainder, we don't want that
-                do_asm("xor ah, ah");
+                return false;
             }
+            is_copy = true;
         }
-        else if (op == "%=")
-        {
+    }
+    else if (value_branch->getType() != "number")
+    {
+        return false;
+    }
+
+    struct stmt_info s_info;
+    std::string end_label = build_unique_label();
+    std::string rep_ins = (is_copy ? "movs" : "stos");
+    rep_ins += (elem_size == 2 ? "w" : "b");
+
+    do_asm("; FOR STATEMENT, BLOCK " + std::string(is_copy ? "COPY" : "FILL"));
+    calculate_scope_size(std::dynamic_pointer_cast<ScopeBranch>(branch));
+
+    // Handle the init branch, the index will then hold its starting value so we can calculate the first addresses
+    handle_stmt(&s_info, init_branch);
+
+    // The total elements is "bound - i", if the loop would never run then skip it entirely
+    make_expression(bound_branch, &s_info);
+    make_move_reg_variable("cx", std::dynamic_pointer_cast<VarIdentifierBranch>(cond_branch->getFirstChild()), &s_info);
+    do_asm("cmp ax, cx");
+    if (index_vdef_branch->isSigned())
+    {
+        do_asm("jle " + end_label);
+    }
+    else
+    {
+        do_asm("jbe " + end_label);
+    }
+    do_asm("sub ax, cx");
+    do_asm("push ax");
+
+    // Calculating addresses may use SI and DI so we store them on the stack until we are ready
+    if (is_copy)
+    {
+        make_move_var_addr_to_reg(&s_info, "ax", std::dynamic_pointer_cast<VarIdentifierBranch>(value_branch));
+        do_asm("push ax");
+    }
+
+    make_move_var_addr_to_reg(&s_info, "ax", std::dynamic_pointer_cast<VarIdentifierBranch>(dest_branch));
+    do_asm("push ax");
+
+    if (!is_copy)
+    {
+        // AX will hold the value to fill with
+        make_expression(value_branch, &s_info);
+    }
+
+    do_asm("pop di");
+    if (is_copy)
+    {
+        do_asm("pop si");
+    }
+    do_asm("pop cx");
+
+    // This code generator does not use segments so ES is expected to be the same as DS
+    do_asm("cld");
+    do_asm("rep " + rep_ins);
+
+    make_exact_label(end_label);
+    reset_scope_size();
+    return true;
+}
+
+bool CodeGen8086::is_cx_preserved(std::shared_ptr<Branch> branch)
+{
+    /* Returns true if the code generated for the branch is known to leave the CX register alone.
+     * Expressions keep their right operands in CX and function calls, inline assembly and other loops may use it freely
+     * so only simple moves between variables are allowed */
+    std::string type = branch->getType();
+    if (type == "E" || type == "FUNC_CALL" || type == "ASM" || type == "FOR" || type == "WHILE"
+            || type == "PTR" || type == "LOGICAL_NOT" || type == "ADDRESS_OF" || type == "STRUCT_DEF")
+    {
+        return false;
+    }
+
+    if (type == "ASSIGN" && std::dynamic_pointer_cast<AssignBranch>(branch)->getOperator() != "=")
+    {
+        // Compound assignments do their work in CX
+        return false;
+    }
+
+    if (type == "VAR_IDENTIFIER")
+    {
+        std::shared_ptr<VarIdentifierBranch> var_iden_branch = std::dynamic_pointer_cast<VarIdentifierBranch>(branch);
+        std::shared_ptr<VDEFBranch> vdef_branch = var_iden_branch->getVariableDefinitionBranch();
+        if (var_iden_branch->hasStructureAccessBranch()
+                || (!vdef_branch->isPrimitive() && !vdef_branch->isPointer()))
+        {
+            return false;
+        }
+
+        // Array indexes are scaled with adds as long as the element size is a power of two
+        if (var_iden_branch->hasRootArrayIndexBranch())
+        {
+            int elem_size = vdef_branch->getDataTypeBranch()->getDataTypeSize(true);
+            if (var_iden_branch->getRootArrayIndexBranch()->hasNextArrayIndexBranch()
+                    || (elem_size & (elem_size - 1)) != 0)
+            {
+                return false;
+            }
+        }
+    }
+
+    for (std::shared_ptr<Branch> child : branch->getChildren())
+    {
+        if (!is_cx_preserved(child))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool CodeGen8086::make_counted_loop(std::shared_ptr<FORBranch> branch)
+{
+    /* Recognises loops whose trip count is known before the first iteration such as:
+     * for (uint8 i = 0; i < size; i += 1) { ... }
+     * for (uint16 i = 10; i != 0; i = i - 1) { ... }
+     * and counts the iterations down in CX using "loop" rather than comparing the variable every time around.
+     * If the body would destroy CX then the count is kept in the induction variable itself with "dec"/"jnz",
+     * that is only possible when nothing can see the variable. If the loop is not countable then false is returned and nothing is generated */
+    std::shared_ptr<Branch> init_branch = branch->getInitBranch();
+    std::shared_ptr<Branch> cond_branch = branch->getCondBranch();
+    std::shared_ptr<Branch> loop_branch = branch->getLoopBranch();
+    std::shared_ptr<Branch> body_branch = branch->getBodyBranch();
+
+    std::shared_ptr<VDEFBranch> index_vdef_branch = NULL;
+    bool is_scoped_index = false;
+    if (init_branch->getType() == "V_DEF")
+    {
+        index_vdef_branch = std::dynamic_pointer_cast<VDEFBranch>(init_branch);
+        if (!index_vdef_branch->hasValueExpBranch())
+        {
+            return false;
+        }
+        is_scoped_index = true;
+    }
+    else if (init_branch->getType() == "ASSIGN"
+            && std::dynamic_pointer_cast<AssignBranch>(init_branch)->getOperator() == "="
+            && std::dynamic_pointer_cast<AssignBranch>(init_branch)->getVariableToAssignBranch()->getType() == "VAR_IDENTIFIER")
+    {
+        std::shared_ptr<VarIdentifierBranch> var_iden_branch = std::dynamic_pointer_cast<VarIdentifierBranch>(std::dynamic_pointer_cast<AssignBranch>(init_branch)->getVariableToAssignBranch());
+        if (!var_iden_branch->isVariableAlone())
+        {
+            return false;
+        }
+        index_vdef_branch = var_iden_branch->getVariableDefinitionBranch();
+    }
+    else
+    {
+        return false;
+    }
+
+    int index_size = index_vdef_branch->getDataTypeBranch()->getDataTypeSize();
+    if (index_vdef_branch->getVariableType() == VARIABLE_TYPE_GLOBAL_VARIABLE
+            || index_vdef_branch->isPointer()
+            || index_vdef_branch->getVariableIdentifierBranch()->hasRootArrayIndexBranch()
+            || (index_size != 1 && index_size != 2)
+            || get_held_argument_register(index_vdef_branch) != ""
+            || is_address_taken(this->cur_func, index_vdef_branch))
+    {
+        return false;
+    }
+
+    // The loop must step the index by one
+    int step;
+    if (!get_induction_step(loop_branch, index_vdef_branch, &step)
+            || (step != 1 && step != -1))
+    {
+        return false;
+    }
+
+    // The condition must compare the index with a bound that cannot change while we loop
+    std::string op = cond_branch->getValue();
+    if (cond_branch->getType() != "E"
+            || !is_var_iden_for(cond_branch->getFirstChild(), index_vdef_branch)
+            || !(op == "!=" || (step == 1 && (op == "<" || op == "<=")) || (step == -1 && (op == ">" || op == ">="))))
+    {
+        return false;
+    }
+
+    std::shared_ptr<Branch> bound_branch = cond_branch->getSecondChild();
+    std::shared_ptr<VDEFBranch> bound_vdef_branch = NULL;
+    if (bound_branch->getType() == "number")
+    {
+        int bound = std::stoi(bound_branch->getValue());
+        if (bound < 0 || bound > (index_size == 1 ? 0xff : 0xffff))
+        {
+            return false;
+        }
+    }
+    else if (bound_branch->getType() == "VAR_IDENTIFIER" && std::dynamic_pointer_cast<VarIdentifierBranch>(bound_branch)->isVariableAlone())
+    {
+        bound_vdef_branch = std::dynamic_pointer_cast<VarIdentifierBranch>(bound_branch)->getVariableDefinitionBranch();
+        if (bound_vdef_branch == index_vdef_branch
+                || bound_vdef_branch->getVariableType() == VARIABLE_TYPE_GLOBAL_VARIABLE
+                || bound_vdef_branch->isPointer()
+                || bound_vdef_branch->getDataTypeBranch()->getDataTypeSize() > index_size
+                || is_address_taken(this->cur_func, bound_vdef_branch))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        return false;
+    }
+
+    // Neither the index nor the bound may be changed by the body, we also need to know if the body reads the index at all
+    bool is_countable = true;
+    bool body_reads_index = false;
+    std::function<void(std::shared_ptr<Branch>) > scan_func = [&](std::shared_ptr<Branch> branch) -> void
+    {
+        if (branch->getType() == "ASM")
+        {
+            is_countable = false;
+            return;
+        }
+
+        if (branch->getType() == "ASSIGN")
+        {
+            std::shared_ptr<Branch> var_branch = std::dynamic_pointer_cast<AssignBranch>(branch)->getVariableToAssignBranch();
+            if (var_branch->getType() == "VAR_IDENTIFIER")
+            {
+                std::shared_ptr<VDEFBranch> assigned_vdef_branch = std::dynamic_pointer_cast<VarIdentifierBranch>(var_branch)->getVariableDefinitionBranch();
+                if (assigned_vdef_branch == index_vdef_branch || assigned_vdef_branch == bound_vdef_branch)
+                {
+                    is_countable = false;
+                    return;
+                }
+            }
+        }
+        else if (branch->getType() == "VAR_IDENTIFIER"
+                && std::dynamic_pointer_cast<VarIdentifierBranch>(branch)->getVariableDefinitionBranch() == index_vdef_branch)
+        {
+            body_reads_index = true;
+        }
+
+        for (std::shared_ptr<Branch> child : branch->getChildren())
+        {
+            scan_func(child);
+            if (!is_countable)
+            {
+                return;
+            }
+        }
+    };
+    scan_func(body_branch);
+    if (!is_countable)
+    {
+        return false;
+    }
+
+    // When the body leaves CX alone the count lives there, otherwise it can only live in the index variable if nobody will miss it
+    bool use_cx = is_cx_preserved(body_branch);
+    bool keep_index = body_reads_index || !is_scoped_index;
+    if (!use_cx && keep_index)
+    {
+        return false;
+    }
+
+    // Bytes are zero extended when loaded so the trip count of signed byte loops cannot be calculated in a word
+    bool is_signed = index_vdef_branch->isSigned() || (bound_vdef_branch != NULL && bound_vdef_branch->isSigned());
+    if (is_signed && index_size == 1)
+    {
+        return false;
+    }
+
+    struct stmt_info s_info;
+    std::shared_ptr<VarIdentifierBranch> index_var_iden_branch = std::dynamic_pointer_cast<VarIdentifierBranch>(cond_branch->getFirstChild());
+    std::string loop_label = build_unique_label();
+    std::string loop_part_label = build_unique_label();
+
+    do_asm("; FOR STATEMENT, COUNTED");
+    new_breakable_label(branch);
+    new_continue_label(loop_part_label, body_branch);
+    calculate_scope_size(std::dynamic_pointer_cast<ScopeBranch>(branch));
+
+    handle_stmt(&s_info, init_branch);
+
+    // Strength reducing the index must be done before the count is in CX as it may need to multiply
+    bool has_induction_variable = false;
+    if (keep_index)
+    {
+        std::vector<std::shared_ptr<Branch>> loop_parts = {body_branch, loop_branch};
+        has_induction_variable = setup_induction_variable(index_vdef_branch, loop_branch, loop_parts);
+    }
+
+    // The trip count is "bound - i" when counting up or "i - bound" when counting down
+    make_move_reg_variable("cx", index_var_iden_branch, &s_info);
+    make_expression(bound_branch, &s_info);
+    if (step == -1)
+    {
+        do_asm("xchg ax, cx");
+    }
+    do_asm("sub ax, cx");
+
+    // If the loop would never run we skip it entirely
+    if (op == "<" || op == ">")
+    {
+        do_asm((is_signed ? "jle " : "jbe ") + this->breakable_label);
+    }
+    else if (op == "<=" || op == ">=")
+    {
+        do_asm((is_signed ? "jl " : "jb ") + this->breakable_label);
+        do_asm("inc ax");
+    }
+    else if (index_size == 1)
+    {
+        // Bytes wrap around at 256 so "!=" may pass the bound first e.g "i = 250; i != 4" runs 10 times
+        do_asm("xor ah, ah");
+    }
+    do_asm("mov cx, ax");
+    if (op == "!=")
+    {
+        do_asm("jcxz " + this->breakable_label);
+    }
+    this->do_signed = false;
+
+    std::string index_pos = getASMAddressForVariableFormatted(&s_info, index_var_iden_branch);
+    if (!use_cx)
+    {
+        // The index variable becomes the counter
+        do_asm("mov [" + index_pos + "], " + std::string(index_size == 2 ? "cx" : "cl"));
+    }
+
+    make_exact_label(loop_label);
+    handle_body(&s_info, body_branch);
+    make_exact_label(loop_part_label);
+
+    if (use_cx)
+    {
+        if (keep_index)
+        {
+            make_move_reg_variable("ax", index_var_iden_branch, &s_info);
+            do_asm(step == 1 ? "inc ax" : "dec ax");
+            do_asm("mov [" + index_pos + "], " + std::string(index_size == 2 ? "ax" : "al"));
+            if (has_induction_variable)
+            {
+                make_induction_step();
+            }
+        }
+        do_asm("loop " + loop_label);
+    }
+    else
+    {
+        if (index_size == 1)
+        {
+            do_asm("xor ch, ch");
+            do_asm("mov cl, [" + index_pos + "]");
+        }
+        else
+        {
+            do_asm("mov cx, [" + index_pos + "]");
+        }
+        // Moves leave the flags alone so we can still jump on the result of "dec"
+        do_asm("dec cx");
+        do_asm("mov [" + index_pos + "], " + std::string(index_size == 2 ? "cx" : "cl"));
+        do_asm("jne " + loop_label);
+    }
+
+    make_exact_label(this->breakable_label);
+    end_breakable_label();
+    end_continue_label();
+
+    if (has_induction_variable)
+    {
+        end_induction_variable();
+    }
+
+    reset_scope_size();
+    return true;
+}
+
+void CodeGen8086::make_scale_register(std::string reg, int size)
+{
+    // Multiplying by powers of two can be done by adding the register to itself, "mul" is slow and destroys DX
+    if (size > 0 && (size & (size - 1)) == 0)
+    {
+        while (size > 1)
+        {
+            do_asm("add " + reg + ", " + reg);
+            size /= 2;
+        }
+    }
+    else
+    {
+        if (reg != "ax")
+        {
+            throw CodeGeneratorException("void CodeGen8086::make_scale_register(std::string reg, int size): only the AX register may be scaled by a size that is not a power of two");
+        }
+        do_asm("mov cx, " + std::to_string(size));
+        do_asm("mul cx");
+    }
+}
+
+bool CodeGen8086::get_induction_step(std::shared_ptr<Branch> branch, std::shared_ptr<VDEFBranch> vdef_branch, int* step)
+{
+    // Returns true if the branch is "i += c", "i -= c", "i = i + c", "i = c + i" or "i = i - c" where "c" is a number
+    if (branch->getType() != "ASSIGN")
+    {
+        return false;
+    }
+
+    std::shared_ptr<AssignBranch> assign_branch = std::dynamic_pointer_cast<AssignBranch>(branch);
+    std::shared_ptr<Branch> value_branch = assign_branch->getValueBranch();
+    std::string op = assign_branch->getOperator();
+    if (!is_var_iden_for(assign_branch->getVariableToAssignBranch(), vdef_branch))
+    {
+        return false;
+    }
+
+    if (op == "+=" || op == "-=")
+    {
+        if (value_branch->getType() != "number")
+        {
+            return false;
+        }
+        *step = std::stoi(value_branch->getValue());
+    }
+    else if (op == "=" && value_branch->getType() == "E"
+            && (value_branch->getValue() == "+" || value_branch->getValue() == "-"))
+    {
+        std::shared_ptr<Branch> left = value_branch->getFirstChild();
+        std::shared_ptr<Branch> right = value_branch->getSecondChild();
+        op = value_branch->getValue();
+        if (is_var_iden_for(left, vdef_branch) && right->getType() == "number")
+        {
+            *step = std::stoi(right->getValue());
+        }
+        else if (op == "+" && is_var_iden_for(right, vdef_branch) && left->getType() == "number")
+        {
+            *step = std::stoi(left->getValue());
+        }
+        else
+        {
+            return false;
+        }
+    }
+    else
+    {
+        return false;
+    }
+
+    if (op == "-=" || op == "-")
+    {
+        *step = -*step;
+    }
+
+    return true;
+}
+
+bool CodeGen8086::is_address_taken(std::shared_ptr<Branch> branch, std::shared_ptr<VDEFBranch> vdef_branch)
+{
+    if (branch->getType() == "ADDRESS_OF")
+    {
+        std::shared_ptr<AddressOfBranch> address_of_branch = std::dynamic_pointer_cast<AddressOfBranch>(branch);
+        if (address_of_branch->getVariableIdentifierBranch()->getVariableDefinitionBranch() == vdef_branch)
+        {
+            return true;
+        }
+    }
+
+    for (std::shared_ptr<Branch> child : branch->getChildren())
+    {
+        if (is_address_taken(child, vdef_branch))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool CodeGen8086::setup_induction_variable(std::shared_ptr<VDEFBranch> vdef_branch, std::shared_ptr<Branch> step_branch, std::vector<std::shared_ptr<Branch>> loop_parts)
+{
+    /* An induction variable is only ever changed by a constant step, so rather than multiplying it by the element size
+     * every time it is used as an array index we keep "i * elem_size" in SI and add "step * elem_size" to SI when "i" is stepped.
+     * If every indexed access goes through the same pointer that does not change in the loop then the pointer load is hoisted out 
+     * as well and SI holds the address of the element itself.
+     * 
+     * SI is not used by anything else the code generator produces inside a loop but function calls and inline assembly may destroy it,
+     * so loops containing them (and nested loops) are left alone, as are functions holding their arguments in SI */
+    int step;
+    if (this->induction_vdef != NULL
+            || !this->held_arguments.empty()
+            || vdef_branch->getVariableType() == VARIABLE_TYPE_GLOBAL_VARIABLE
+            || vdef_branch->isPointer()
+            || vdef_branch->getVariableIdentifierBranch()->hasRootArrayIndexBranch()
+            || !get_induction_step(step_branch, vdef_branch, &step)
+            || is_address_taken(this->cur_func, vdef_branch))
+    {
+        return false;
+    }
+
+    bool is_suitable = true;
+    std::vector<std::shared_ptr<VarIdentifierBranch>> accesses;
+    std::vector<std::shared_ptr<VDEFBranch>> assigned_vdefs;
+    std::function<void(std::shared_ptr<Branch>) > scan_func = [&](std::shared_ptr<Branch> branch) -> void
+    {
+        std::string type = branch->getType();
+        if (type == "FUNC_CALL" || type == "ASM" || type == "FOR" || type == "WHILE")
+        {
+            is_suitable = false;
+            return;
+        }
+
+        if (type == "ASSIGN" && branch != step_branch)
+        {
+            std::shared_ptr<Branch> var_branch = std::dynamic_pointer_cast<AssignBranch>(branch)->getVariableToAssignBranch();
+            if (var_branch->getType() == "VAR_IDENTIFIER")
+            {
+                std::shared_ptr<VDEFBranch> assigned_vdef_branch = std::dynamic_pointer_cast<VarIdentifierBranch>(var_branch)->getVariableDefinitionBranch();
+                if (assigned_vdef_branch == vdef_branch)
+                {
+                    // The induction variable is changed somewhere else
+                    is_suitable = false;
+                    return;
+                }
+                assigned_vdefs.push_back(assigned_vdef_branch);
+            }
+        }
+        else if (type == "VAR_IDENTIFIER" && get_indexed_elem_size(branch, vdef_branch) != 0)
+        {
+            accesses.push_back(std::dynamic_pointer_cast<VarIdentifierBranch>(branch));
+        }
+
+        for (std::shared_ptr<Branch> child : branch->getChildren())
+        {
+            scan_func(child);
+            if (!is_suitable)
+            {
+                return;
+            }
+        }
+    };
+
+    for (std::shared_ptr<Branch> part : loop_parts)
+    {
+        scan_func(part);
+    }
+
+    if (!is_suitable || accesses.empty())
+    {
+        return false;
+    }
+
+    std::shared_ptr<VarIdentifierBranch> first_access = accesses.front();
+    std::shared_ptr<VDEFBranch> base_vdef_branch = first_access->getVariableDefinitionBranch();
+    int elem_size = get_indexed_elem_size(first_access, vdef_branch);
+
+    // Can the base pointer be hoisted out of the loop?
+    bool hoist_base = base_vdef_branch->isPointer()
+            && !base_vdef_branch->getVariableIdentifierBranch()->hasRootArrayIndexBranch()
+            && base_vdef_branch->getVariableType() != VARIABLE_TYPE_GLOBAL_VARIABLE
+            && std::find(assigned_vdefs.begin(), assigned_vdefs.end(), base_vdef_branch) == assigned_vdefs.end()
+            && !is_address_taken(this->cur_func, base_vdef_branch);
+    for (std::shared_ptr<VarIdentifierBranch> access : accesses)
+    {
+        if (access->getVariableDefinitionBranch() != base_vdef_branch)
+        {
+            hoist_base = false;
+            break;
+        }
+    }
+
+    struct stmt_info s_info;
+    std::shared_ptr<VarIdentifierBranch> index_var_iden_branch = std::dynamic_pointer_cast<VarIdentifierBranch>(first_access->getRootArrayIndexBranch()->getValueBranch());
+    do_asm("; INDUCTION VARIABLE");
+    make_move_reg_variable("ax", index_var_iden_branch, &s_info);
+    make_scale_register("ax", elem_size);
+    do_asm("mov si, ax");
+    if (hoist_base)
+    {
+        std::string pos = getASMAddressForVariableFormatted(&s_info, first_access, true);
+        do_asm("mov ax, [" + pos + "]");
+        do_asm("add si, ax");
+    }
+    this->do_signed = false;
+
+    this->induction_vdef = vdef_branch;
+    this->induction_base_vdef = hoist_base ? base_vdef_branch : NULL;
+    this->induction_step_branch = step_branch;
+    this->induction_elem_size = elem_size;
+    this->induction_step = step * elem_size;
+    return true;
+}
+
+void CodeGen8086::make_induction_step()
+{
+    if (this->induction_step > 0)
+    {
+        do_asm("add si, " + std::to_string(this->induction_step));
+    }
+    else if (this->induction_step < 0)
+    {
+        do_asm("sub si, " + std::to_string(-this->induction_step));
+    }
+}
+
+void CodeGen8086::end_induction_variable()
+{
+    this->induction_vdef = NULL;
+    this->induction_base_vdef = NULL;
+    this->induction_step_branch = NULL;
+    this->induction_elem_size = 0;
+    this->induction_step = 0;
+}
+
+void CodeGen8086::handle_struct_access(struct stmt_info* s_info, std::shared_ptr<STRUCTAccessBranch> struct_access_branch)
+{
+    std::string pos = std::to_string(struct_access_branch->getVarIdentifierBranch()->getVariableDefinitionBranch(true)->getPositionRelScope());
+    do_asm("mov bx, [bx+" + pos + "]");
+}
+
+std::string CodeGen8086::make_var_access(struct stmt_info* s_info, std::shared_ptr<VarIdentifierBranch> var_branch, int* data_size)
+{
+    std::string pos = "";
+    pos = getASMAddressForVariableFormatted(s_info, var_branch);
+    if (data_size != NULL)
+    {
+        std::shared_ptr<VDEFBranch> vdef_branch = var_branch->getVariableDefinitionBranch();
+        // Expressions should use a lower register for compare expressions if this variable fits into a byte
+        if (vdef_branch->getDataTypeBranch()->getDataTypeSize() == 1)
+        {
+            if (s_info->exp_info.last_compare_exp_info != NULL)
+            {
+                s_info->exp_info.last_compare_exp_info->use_low_reg = true;
+            }
+        }
+
+        bool no_pointer = false;
+        /*
+         * When accessing pointers with an array index whose definition has no array index
+         * then we should get the size as if it was not a pointer as we are accessing an array pointed to by a pointer such as a character
+         * array, e.g
+         * uint8* message = "Hello World";
+         * return message[3];
+         */
+        if (var_branch->getFinalVarIdentifierBranch()->hasRootArrayIndexBranch() && vdef_branch->isPointer() && !vdef_branch->getVariableIdentifierBranch()->hasRootArrayIndexBranch())
+        {
+            no_pointer = true;
+        }
+        else if (s_info->is_child_of_pointer)
+        {
+            /*
+             * It is also possible that you could be accessing something as a pointer and depending on the depth will determine the data size.
+             * For example:
+             * uint8 a = 50;
+             * uint8* ptr = &a;
+             * uint8** pptr = &ptr;
+             * 
+             * return *ptr - Data size is one byte
+             * return *pptr - Data size is two bytes
+             * return **pptr - Data size is one byte as we are getting the value of "a"
+             * 
+             * The algorithm for this is quite simple essentially if the pointer depth is equal to the pointer depth
+             * of the pointer variable then we should get the size as if its not a pointer.
+             * If it is not equal then it means it is accessing another address so it must be the size of a pointer.
+             */
+
+            int vdef_pointer_depth = vdef_branch->getPointerDepth();
+            if (vdef_pointer_depth == s_info->pointer_your_child_of->getPointerDepth())
+            {
+                no_pointer = true;
+            }
+        }
+        *data_size = var_branch->getVariableDefinitionBranch()->getDataTypeBranch()->getDataTypeSize(no_pointer);
+    }
+    return pos;
+}
+
+void CodeGen8086::make_appendment(std::string target_reg, std::string op, std::string old_value)
+{
+    if (target_reg == "ax" || target_reg == "cx")
+    {
+        throw Exception("It is not possible to use the ax or cx register", "void CodeGen8086::make_appendment(std::string target_reg, std::string op, std::string old_value)");
+    }
+
+    // Load the old value, this is either a memory operand or the register an argument is held in
+    do_asm("mov " + target_reg + ", " + old_value);
+    if (op == "+=")
+    {
+        do_asm("add " + target_reg + ", ax");
+    }
+    else if (op == "-=")
+    {
+        do_asm("sub " + target_reg + ", ax");
+    }
+    else if (op == "*=" || op == "/=" || op == "%=")
+    {
+        bool using_cx = false;
+        std::string old_target_reg = target_reg;
+        if (target_reg == "dx")
+        {
+            // Multiplication, division and modulas use the DX register so we cannot use it
+            // Save CX
+            do_asm("push cx");
+            target_reg = "cx";
+            using_cx = true;
+        }
+
+        // We must move the old target register to the CX register as we will perform operations on it
+        do_asm("mov cx, " + old_target_reg);
+        
+        /* Now we must exchange CX and AX as AX contains the operand, e.g a += 5;. AX contains 5 we want to perform
+         * var = var * new_value; not var = new_value * var
+         */
+        do_asm("xchg ax, cx");
+        
+        // We must blank DX as the following instructions perform like this DX:AX operator operand
+        do_asm("xor dx, dx");
+
+        if (op == "/=")
+        {
+            if (do_signed)
+            {
+                do_asm("idiv " + target_reg);
+            }
+            else
+            {
+                do_asm("div " + target_reg);
+            }
+
+            if (!is_gen_reg_16_bit(target_reg))
+            {
+                // AH contains remainder, we don't want that
+                do_asm("xor ah, ah");
+            }
+        }
+        else if (op == "%=")
+        {
             // We must blank DX as div and idiv perform like this DX:AX / operand
             do_asm("xor dx, dx");
             do_asm("div " + target_reg);
@@ -1159,7 +2097,7 @@ void CodeGen8086::make_appendment(std::string target_reg, std::string op, std::s
     }
     else
     {
-        throw Exception("Appendment operator \"" + op + "\" is not implemented.", "void CodeGen8086::make_appendment(std::string target_reg, std::string op, std::string pos)");
+        throw Exception("Appendment operator \"" + op + "\" is not implemented.", "void CodeGen8086::make_appendment(std::string target_reg, std::string op, std::string old_value)");
     }
 }
 
@@ -1188,7 +2126,7 @@ void CodeGen8086::make_var_assignment(std::shared_ptr<Branch> var_branch, std::s
         if (op != "=")
         {
             // Ok this is an appendment so we need to adjust the value before setting it again
-            make_appendment("dx", op, "bx");
+            make_appendment("dx", op, "[bx]");
             // Overwrite AX with the appended value
             do_asm("mov ax, dx");
         }
@@ -1201,6 +2139,16 @@ void CodeGen8086::make_var_assignment(std::shared_ptr<Branch> var_branch, std::s
         std::shared_ptr<VarIdentifierBranch> var_iden_branch = std::dynamic_pointer_cast<VarIdentifierBranch>(var_branch);
         std::shared_ptr<VDEFBranch> vdef_in_question_branch = var_iden_branch->getVariableDefinitionBranch();
 
+        // Whole structures are copied from the structure variable we are assigned e.g "a = b;"
+        if (var_iden_branch->isVariableAlone() && !vdef_in_question_branch->isPrimitive() && !vdef_in_question_branch->isPointer())
+        {
+            std::shared_ptr<VarIdentifierBranch> value_var_iden_branch = std::dynamic_pointer_cast<VarIdentifierBranch>(value);
+            std::string from_pos = make_var_access(&s_info, value_var_iden_branch);
+            pos = make_var_access(&s_info, var_iden_branch);
+            make_move_mem_to_mem(pos, from_pos, vdef_in_question_branch->getSize());
+            return;
+        }
+
         // Are we assigning a pointer?
         if (vdef_in_question_branch->isPointer())
         {
@@ -1211,6 +2159,19 @@ void CodeGen8086::make_var_assignment(std::shared_ptr<Branch> var_branch, std::s
         // Make the value expression
         make_expression(value, &s_info);
 
+        // Arguments held in a register are assigned by moving the value into that register
+        std::string held_reg = get_held_argument_register(vdef_in_question_branch);
+        if (held_reg != "")
+        {
+            if (op != "=")
+            {
+                make_appendment("dx", op, held_reg);
+                do_asm("mov ax, dx");
+            }
+            do_asm("mov " + held_reg + ", ax");
+            return;
+        }
+
         int data_size;
         s_info.is_assignment_variable = true;
         pos = make_var_access(&s_info, var_iden_branch, &data_size);
@@ -1222,7 +2183,7 @@ void CodeGen8086::make_var_assignment(std::shared_ptr<Branch> var_branch, std::s
         if (op != "=")
         {
             // Ok this is an appendment so we need to adjust the value before setting it again
-            make_appendment("dx", op, pos);
+            make_appendment("dx", op, "[" + pos + "]");
             // Overwrite AX with the appended value
             do_asm("mov ax, dx");
         }
@@ -1259,7 +2220,7 @@ void CodeGen8086::calculate_scope_size(std::shared_ptr<ScopeBranch> scope_branch
         this->scope_size += for_branch->getBodyBranch()->getScopeSize();
     }
     // Generate some ASM to reserve space on the stack for this scope
-    do_asm("sub sp, " + std::to_string(this->scope_size));
+    make_stack_reserve(this->scope_size);
 
     current_scopes_sizes.push_back(this->scope_size);
 
@@ -1268,7 +2229,7 @@ void CodeGen8086::calculate_scope_size(std::shared_ptr<ScopeBranch> scope_branch
 void CodeGen8086::reset_scope_size()
 {
     // Add the stack pointer by the scope size so the memory is recycled.
-    do_asm("add sp, " + std::to_string(this->scope_size));
+    make_stack_release(this->scope_size);
     current_scopes_sizes.pop_back();
 
     if (current_scopes_sizes.empty())
@@ -1281,6 +2242,107 @@ void CodeGen8086::reset_scope_size()
     }
 }
 
+void CodeGen8086::make_stack_reserve(int size)
+{
+    // Scopes without any variables have nothing to reserve
+    if (size != 0)
+    {
+        do_asm("sub sp, " + std::to_string(size));
+    }
+}
+
+void CodeGen8086::make_stack_release(int size)
+{
+    if (size != 0)
+    {
+        do_asm("add sp, " + std::to_string(size));
+    }
+}
+
+bool CodeGen8086::is_frame_needed(std::shared_ptr<FuncBranch> func_branch)
+{
+    /* The 8086 can only address memory through BX, BP, SI and DI so there is no way to address the stack relative to SP.
+     * A function with no arguments or variables on the stack needs no frame, arguments held in registers are never addressed.
+     * Otherwise they are addressed through BP unless BX can hold a copy of SP for the whole function instead */
+    if (func_branch->getArgumentsBranch()->getChildren().size() == this->held_arguments.size()
+            && !has_frame_dependant_branch(func_branch->getBodyBranch()))
+    {
+        return false;
+    }
+
+    return !is_bx_frame_possible(func_branch->getBodyBranch());
+}
+
+bool CodeGen8086::has_frame_dependant_branch(std::shared_ptr<Branch> branch)
+{
+    // Inline assembly may expect BP to point to a frame so we must play it safe
+    if (branch->getType() == "V_DEF" ||
+            branch->getType() == "STRUCT_DEF" ||
+            branch->getType() == "ASM")
+    {
+        return true;
+    }
+
+    for (std::shared_ptr<Branch> child : branch->getChildren())
+    {
+        if (has_frame_dependant_branch(child))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool CodeGen8086::is_bx_frame_possible(std::shared_ptr<Branch> branch)
+{
+    /* BX can only be given to the frame when nothing else will load it. Pointers, arrays, structures and switch jump tables are addressed through BX
+     * and called functions and inline assembly may destroy it. Only plain variables are left which are always at a known offset from the frame */
+    std::string type = branch->getType();
+    if (type == "FUNC_CALL" || type == "ASM" || type == "SWITCH" || type == "PTR" || type == "ADDRESS_OF" || type == "STRUCT_DEF")
+    {
+        return false;
+    }
+
+    if (type == "VAR_IDENTIFIER")
+    {
+        std::shared_ptr<VarIdentifierBranch> var_iden_branch = std::dynamic_pointer_cast<VarIdentifierBranch>(branch);
+        if (var_iden_branch->hasRootArrayIndexBranch() || var_iden_branch->hasStructureAccessBranch())
+        {
+            return false;
+        }
+    }
+
+    for (std::shared_ptr<Branch> child : branch->getChildren())
+    {
+        if (!is_bx_frame_possible(child))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+struct VARIABLE_ADDRESS CodeGen8086::get_bx_frame_address(struct VARIABLE_ADDRESS bp_address)
+{
+    /* BX was set to SP once the function reserved its variables so it is "cur_func_scope_size" bytes below where BP would be.
+     * There is no saved BP between the variables and the return address so arguments are also two bytes closer */
+    int offset = (bp_address.op == "-" ? -bp_address.offset : bp_address.offset);
+    if (offset > 0)
+    {
+        offset -= 2;
+    }
+    offset += this->cur_func_scope_size;
+
+    struct VARIABLE_ADDRESS address;
+    address.segment = "bx";
+    address.op = (offset < 0 ? "-" : "+");
+    address.offset = (offset < 0 ? -offset : offset);
+    address.apply_reg = bp_address.apply_reg;
+    return address;
+}
+
 void CodeGen8086::handle_ptr(struct stmt_info* s_info, std::shared_ptr<PTRBranch> ptr_branch)
 {
     do_asm("; POINTER HANDLING ");
@@ -1299,6 +2361,7 @@ void CodeGen8086::handle_global_var_def(std::shared_ptr<VDEFBranch> vdef_branch)
 {
     // Push this variable definition to the global variables vector
     this->global_variables.push_back(vdef_branch);
+    this->global_variable_positions[vdef_branch->getPositionRelZero()] = vdef_branch;
 
     // Handle the variable declaration
     std::shared_ptr<VarIdentifierBranch> variable_iden_branch = vdef_branch->getVariableIdentifierBranch();
@@ -1318,8 +2381,6 @@ void CodeGen8086::handle_global_var_def(std::shared_ptr<VDEFBranch> vdef_branch)
         value_branch = vdef_branch->getValueExpBranch();
     }
 
-    make_label(variable_name_branch->getValue(), "data");
-
     if (variable_iden_branch->hasRootArrayIndexBranch())
     {
         data_write_macro = "rb";
@@ -1352,9 +2413,50 @@ void CodeGen8086::handle_global_var_def(std::shared_ptr<VDEFBranch> vdef_branch)
         }
     }
 
+    /* Variables that start as zero do not need their bytes stored in the object file or executable,
+     * with "-bss_zeroing" they are reserved in the "bss" segment which the linker places after everything else and zeroes on startup.
+     * Otherwise nothing would zero them so they stay in the "data" segment with their zeros stored */
+    std::string segment = "data";
+    if ((data_write_macro == "rb" || data_write_macro_value == "0") && getCompiler()->hasArgument("bss_zeroing"))
+    {
+        segment = "bss";
+        if (data_write_macro != "rb")
+        {
+            data_write_macro_value = (data_write_macro == "dw" ? "2" : "1");
+            data_write_macro = "rb";
+        }
+        this->total_bss_bytes += std::stoi(data_write_macro_value);
+    }
+
+    // The padding must match the padding the root scope accounts for when calculating variable positions
+    int alignment = getVariableAlignment(vdef_branch->getRootScope(), vdef_branch);
+    if (alignment > 1)
+    {
+        do_asm("align " + std::to_string(alignment), segment);
+    }
+
+    make_label(variable_name_branch->getValue(), segment);
+    do_asm(data_write_macro + " " + data_write_macro_value, segment);
+
+}
 
-    do_asm(data_write_macro + " " + data_write_macro_value, "data");
+struct VARIABLE_ADDRESS CodeGen8086::get_global_variable_address(int abs_position)
+{
+    /* Global variables may live in different segments so we address them from their own label,
+     * find the variable whose bytes the position falls in */
+    std::map<int, std::shared_ptr<VDEFBranch>>::iterator it = this->global_variable_positions.upper_bound(abs_position);
+    if (it == this->global_variable_positions.begin())
+    {
+        throw Exception("No global variable is at position " + std::to_string(abs_position), "struct VARIABLE_ADDRESS CodeGen8086::get_global_variable_address(int abs_position)");
+    }
+    it--;
 
+    struct VARIABLE_ADDRESS address;
+    address.segment = "_" + it->second->getVariableIdentifierBranch()->getVariableNameBranch()->getValue();
+    address.op = "+";
+    address.offset = abs_position - it->first;
+    address.apply_reg = "";
+    return address;
 }
 
 void CodeGen8086::handle_structure(std::shared_ptr<STRUCTBranch> struct_branch)
@@ -1379,8 +2481,18 @@ void CodeGen8086::handle_function(std::shared_ptr<FuncBranch> func_branch)
     std::shared_ptr<Branch> arguments_branch = func_branch->getArgumentsBranch();
     std::shared_ptr<BODYBranch> body_branch = func_branch->getBodyBranch();
 
-    // Make the function global.
-    do_asm("global _" + name_branch->getValue());
+    /* Every function but the first gets a segment of its own so the linker can remove it if nothing calls it.
+     * The first function stays in the code segment as execution begins there */
+    if (getCompiler()->hasArgument("function_sections") && this->total_functions != 0)
+    {
+        setCodeSegment(FUNCTION_SECTION_PREFIX + name_branch->getValue());
+    }
+
+    // Make the function global unless it is private to this file
+    if (!func_branch->isStatic())
+    {
+        do_asm("global _" + name_branch->getValue());
+    }
 
     // Make the function label
     make_label(name_branch->getValue());
@@ -1388,10 +2500,39 @@ void CodeGen8086::handle_function(std::shared_ptr<FuncBranch> func_branch)
     this->cur_func = func_branch;
     this->cur_func_scope_size = body_branch->getScopeSize();
 
-    do_asm("push bp");
-    do_asm("mov bp, sp");
-    // Generate some ASM to reserve space on the stack for this scope
-    do_asm("sub sp, " + std::to_string(this->cur_func_scope_size));
+    /* Arguments passed in registers are kept in registers if nothing in the function would destroy them,
+     * otherwise they are stored where the stack calling convention would have put them */
+    int total_register_args = get_register_argument_count(func_branch);
+    if (!make_register_argument_hold(func_branch, total_register_args))
+    {
+        make_register_argument_spill(total_register_args);
+    }
+
+    this->total_functions++;
+    this->cur_func_has_frame = is_frame_needed(func_branch);
+    this->cur_func_has_bx_frame = false;
+    if (this->cur_func_has_frame)
+    {
+        do_asm("push bp");
+        do_asm("mov bp, sp");
+        // Generate some ASM to reserve space on the stack for this scope
+        make_stack_reserve(this->cur_func_scope_size);
+    }
+    else
+    {
+        this->total_elided_frames++;
+        if (func_branch->getArgumentsBranch()->getChildren().size() != this->held_arguments.size()
+                || has_frame_dependant_branch(body_branch))
+        {
+            // SP only changes within the function by reserving nested scopes so a copy of it taken now works just as well as BP
+            make_stack_reserve(this->cur_func_scope_size);
+            do_asm("mov bx, sp");
+            this->cur_func_has_bx_frame = true;
+            this->total_bx_frames++;
+        }
+    }
+
+    this->cur_func_body_label = make_unique_label();
 
     // Handle the arguments
     handle_func_args(arguments_branch);
@@ -1399,7 +2540,7 @@ void CodeGen8086::handle_function(std::shared_ptr<FuncBranch> func_branch)
     // Handle the body
     handle_body(&s_info, body_branch);
 
-
+    setCodeSegment("code");
 }
 
 void CodeGen8086::handle_func_args(std::shared_ptr<Branch> arguments)
@@ -1417,6 +2558,121 @@ void CodeGen8086::handle_func_args(std::shared_ptr<Branch> arguments)
     }
 }
 
+int CodeGen8086::get_register_argument_count(std::shared_ptr<FuncDefBranch> func_def_branch)
+{
+    if (func_def_branch == NULL || !func_def_branch->isRegisterCall())
+    {
+        return 0;
+    }
+
+    int total_args = func_def_branch->getArgumentsBranch()->getChildren().size();
+    if (total_args > REGISTER_CALL_MAX_ARGUMENTS)
+    {
+        total_args = REGISTER_CALL_MAX_ARGUMENTS;
+    }
+
+    return total_args;
+}
+
+bool CodeGen8086::make_register_argument_hold(std::shared_ptr<FuncBranch> func_branch, int total_register_args)
+{
+    /* Register arguments can stay in SI and DI for the whole function when nothing the function does can destroy them.
+     * Function calls and inline assembly may use any register, array indexes need DI and nothing can take the address of a register.
+     * Every argument must be held, otherwise the stack arguments would not be where the stack calling convention expects them.
+     * Returns true and moves the arguments into their registers if they are held */
+    this->held_arguments.clear();
+    std::vector<std::shared_ptr<Branch>> arguments = func_branch->getArgumentsBranch()->getChildren();
+    if (total_register_args == 0 || total_register_args != (int) arguments.size())
+    {
+        return false;
+    }
+
+    for (std::shared_ptr<Branch> arg : arguments)
+    {
+        std::shared_ptr<VDEFBranch> arg_vdef = std::dynamic_pointer_cast<VDEFBranch>(arg);
+        if (arg_vdef->isPointer()
+                || !arg_vdef->isPrimitive()
+                || arg_vdef->getVariableIdentifierBranch()->hasRootArrayIndexBranch()
+                || is_address_taken(func_branch, arg_vdef))
+        {
+            return false;
+        }
+    }
+
+    bool is_suitable = true;
+    bool uses_array_index = false;
+    std::function<void(std::shared_ptr<Branch>) > scan_func = [&](std::shared_ptr<Branch> branch) -> void
+    {
+        std::string type = branch->getType();
+        if (type == "FUNC_CALL" || type == "ASM")
+        {
+            is_suitable = false;
+            return;
+        }
+
+        if (type == "VAR_IDENTIFIER" && std::dynamic_pointer_cast<VarIdentifierBranch>(branch)->hasRootArrayIndexBranch())
+        {
+            uses_array_index = true;
+        }
+
+        for (std::shared_ptr<Branch> child : branch->getChildren())
+        {
+            scan_func(child);
+            if (!is_suitable)
+            {
+                return;
+            }
+        }
+    };
+    scan_func(func_branch->getBodyBranch());
+
+    int total_free_registers = (uses_array_index ? 1 : 2);
+    if (!is_suitable || total_register_args > total_free_registers)
+    {
+        return false;
+    }
+
+    for (int i = 0; i < total_register_args; i++)
+    {
+        std::shared_ptr<VDEFBranch> arg_vdef = std::dynamic_pointer_cast<VDEFBranch>(arguments.at(i));
+        this->held_arguments[arg_vdef] = held_argument_registers[i];
+        do_asm("mov " + held_argument_registers[i] + ", " + register_call_registers[i]);
+    }
+
+    this->total_held_arguments += total_register_args;
+    return true;
+}
+
+std::string CodeGen8086::get_held_argument_register(std::shared_ptr<VDEFBranch> vdef_branch)
+{
+    // Returns the register the argument is held in or a blank string if it is not held in one
+    auto it = this->held_arguments.find(vdef_branch);
+    if (it == this->held_arguments.end())
+    {
+        return "";
+    }
+
+    return it->second;
+}
+
+void CodeGen8086::make_register_argument_spill(int total_register_args)
+{
+    if (total_register_args == 0)
+    {
+        return;
+    }
+
+    /* The register arguments are pushed beneath the return address so that every argument ends up at the same "bp" offset 
+     * as it would with the stack calling convention. BX is free to use here as nothing is expected to survive in it across a call.
+     * The function will release these pushes itself when it returns */
+    do_asm("pop bx");
+    for (int i = total_register_args - 1; i >= 0; i--)
+    {
+        do_asm("push " + register_call_registers[i]);
+    }
+    do_asm("push bx");
+}
+
 void CodeGen8086::handle_body(struct stmt_info* s_info, std::shared_ptr<Branch> body)
 {
     new_scope(std::dynamic_pointer_cast<StandardScopeBranch>(body));
@@ -1434,6 +2690,12 @@ void CodeGen8086::handle_stmt(struct stmt_info* s_info, std::shared_ptr<Branch>
     {
         std::shared_ptr<AssignBranch> assign_branch = std::dynamic_pointer_cast<AssignBranch>(branch);
         handle_scope_assignment(assign_branch);
+
+        // Keep SI in step with the induction variable
+        if (branch == this->induction_step_branch)
+        {
+            make_induction_step();
+        }
     }
     else if (branch->getType() == "ASM")
     {
@@ -1479,6 +2741,17 @@ void CodeGen8086::handle_stmt(struct stmt_info* s_info, std::shared_ptr<Branch>
         std::shared_ptr<WhileBranch> while_branch = std::dynamic_pointer_cast<WhileBranch>(branch);
         handle_while_stmt(while_branch);
     }
+    else if (branch->getType() == "SWITCH")
+    {
+        std::shared_ptr<SwitchBranch> switch_branch = std::dynamic_pointer_cast<SwitchBranch>(branch);
+        handle_switch_stmt(switch_branch);
+    }
+    else if (branch->getType() == "CASE" ||
+            branch->getType() == "DEFAULT")
+    {
+        // This is where the switch statement we are in will jump to for this case
+        make_exact_label(this->switch_labels[branch]);
+    }
 }
 
 void CodeGen8086::handle_function_call(std::shared_ptr<FuncCallBranch> branch)
@@ -1490,8 +2763,11 @@ void CodeGen8086::handle_function_call(std::shared_ptr<FuncCallBranch> branch)
 
     std::vector<std::shared_ptr < Branch>> params = func_params_branch->getChildren();
 
+    // Functions using the register calling convention take their first arguments in registers rather than on the stack
+    int total_register_args = get_register_argument_count(branch->getFunctionDefinitionBranch());
+
     // Parameters are treated as an expression, they must be pushed on backwards due to how the stack works
-    for (int i = params.size() - 1; i >= 0; i--)
+    for (int i = params.size() - 1; i >= total_register_args; i--)
     {
         std::shared_ptr<Branch> param = params.at(i);
         make_expression(param, &s_info);
@@ -1499,11 +2775,49 @@ void CodeGen8086::handle_function_call(std::shared_ptr<FuncCallBranch> branch)
         do_asm("push ax");
     }
 
+    /* Making an expression may use any of the argument registers so the register arguments are held on the stack 
+     * until they are all made, the first argument is made last so it can be left in AX. Numbers are loaded straight into their register at the end */
+    for (int i = total_register_args - 1; i >= 0; i--)
+    {
+        std::shared_ptr<Branch> param = params.at(i);
+        if (param->getType() == "number")
+        {
+            continue;
+        }
+
+        make_expression(param, &s_info);
+        if (i != 0)
+        {
+            do_asm("push ax");
+        }
+    }
+
+    for (int i = 1; i < total_register_args; i++)
+    {
+        if (params.at(i)->getType() != "number")
+        {
+            do_asm("pop " + register_call_registers[i]);
+        }
+    }
+
+    for (int i = 0; i < total_register_args; i++)
+    {
+        std::shared_ptr<Branch> param = params.at(i);
+        if (param->getType() == "number")
+        {
+            do_asm("mov " + register_call_registers[i] + ", " + param->getValue());
+        }
+    }
+
     // Now call the function :)
     do_asm("call _" + func_name_branch->getValue());
 
-    /* Restore the stack pointer to what it was to recycle the memory */
-    do_asm("add sp, " + std::to_string(params.size() * 2));
+    /* Restore the stack pointer to what it was to recycle the memory, register arguments are released by the function being called */
+    int total_stack_args = params.size() - total_register_args;
+    if (total_stack_args > 0)
+    {
+        do_asm("add sp, " + std::to_string(total_stack_args * 2));
+    }
 }
 
 void CodeGen8086::handle_scope_assignment(std::shared_ptr<AssignBranch> assign_branch)
@@ -1519,35 +2833,109 @@ void CodeGen8086::handle_func_return(struct stmt_info* s_info, std::shared_ptr<R
 {
     if (return_branch->hasExpressionBranch())
     {
+        std::shared_ptr<Branch> exp_branch = return_branch->getExpressionBranch();
+        // Returning the result of a function call? then that function can return for us
+        if (exp_branch->getType() == "FUNC_CALL" && make_tail_call(std::dynamic_pointer_cast<FuncCallBranch>(exp_branch)))
+        {
+            return;
+        }
+
         // We have something to return
         // AX will be set to the value to return once the expression is complete.
-        make_expression(return_branch->getExpressionBranch(), s_info);
+        make_expression(exp_branch, s_info);
     }
 
     // Restore the stack pointer
-    std::shared_ptr<Branch> branch_to_stop = cur_func->getArgumentsBranch();
-    do_asm("add sp, " + std::to_string(this->current_scope->getScopeSize(GET_SCOPE_SIZE_INCLUDE_PARENT_SCOPES,
-                                                                         [&](std::shared_ptr<Branch> branch) -> bool
-                                                                         {
-                                                                             // We should stop at the function arguments so it doesn't include any more parent scopes when it reaches this point
-                                                                             if (branch == branch_to_stop)
-                                                                             {
-                                                                                 return false;
-                                                                             }
-
-                                                                             return true;
-                                                                         })));
+    make_stack_release(get_func_scope_size_to_release());
 
     // Pop from the stack back to the BP(Base Pointer) now we are leaving this function
-    do_asm("pop bp");
-    do_asm("ret");
+    if (this->cur_func_has_frame)
+    {
+        do_asm("pop bp");
+    }
+
+    // Register arguments were pushed by this function so it must release them unless they were held in registers instead
+    int total_register_args = get_register_argument_count(cur_func);
+    if (total_register_args > 0 && this->held_arguments.empty())
+    {
+        do_asm("ret " + std::to_string(total_register_args * 2));
+    }
+    else
+    {
+        do_asm("ret");
+    }
+}
+
+int CodeGen8086::get_func_scope_size_to_release()
+{
+    std::shared_ptr<Branch> branch_to_stop = cur_func->getArgumentsBranch();
+    return this->current_scope->getScopeSize(GET_SCOPE_SIZE_INCLUDE_PARENT_SCOPES,
+                                             [&](std::shared_ptr<Branch> branch) -> bool
+                                             {
+                                                 // We should stop at the function arguments so it doesn't include any more parent scopes when it reaches this point
+                                                 if (branch == branch_to_stop)
+                                                 {
+                                                     return false;
+                                                 }
+
+                                                 return true;
+                                             });
 }
 
-void CodeGen8086::handle_compare_expression()
+bool CodeGen8086::make_tail_call(std::shared_ptr<FuncCallBranch> func_call_branch)
 {
+    struct stmt_info s_info;
+
+    std::string func_name = func_call_branch->getFuncNameBranch()->getValue();
+    std::vector<std::shared_ptr < Branch>> params = func_call_branch->getFuncParamsBranch()->getChildren();
+    bool is_self_call = func_name == cur_func->getNameBranch()->getValue();
+    if (!is_self_call)
+    {
+        /* Jumping to another function leaves it to return to our caller, who will release the arguments it gave us. 
+         * So the arguments we pass must fit in that area and neither function may release arguments itself */
+        std::shared_ptr<FuncDefBranch> func_def_branch = func_call_branch->getFunctionDefinitionBranch();
+        if (func_def_branch == NULL ||
+                get_register_argument_count(func_def_branch) != 0 ||
+                get_register_argument_count(cur_func) != 0 ||
+                params.size() > cur_func->getArgumentsBranch()->getChildren().size())
+        {
+            return false;
+        }
+    }
+
+    do_asm("; TAIL CALL");
+
+    // The new arguments may depend on our current arguments so they must all be made before we overwrite any of them
+    for (int i = params.size() - 1; i >= 0; i--)
+    {
+        make_expression(params.at(i), &s_info);
+        do_asm("push ax");
+    }
 
+    for (size_t i = 0; i < params.size(); i++)
+    {
+        do_asm("pop ax");
+        // + 4 due to return address and new base pointer
+        do_asm("mov [bp+" + std::to_string(4 + (i * 2)) + "], ax");
+    }
 
+    if (is_self_call)
+    {
+        // Calling ourselves is just a loop, we keep our frame and start the body again
+        make_stack_release(get_func_scope_size_to_release() - this->cur_func_scope_size);
+        do_asm("jmp " + this->cur_func_body_label);
+    }
+    else
+    {
+        make_stack_release(get_func_scope_size_to_release());
+        if (this->cur_func_has_frame)
+        {
+            do_asm("pop bp");
+        }
+        do_asm("jmp _" + func_name);
+    }
 
+    return true;
 }
 
 void CodeGen8086::handle_scope_variable_declaration(std::shared_ptr<VDEFBranch> def_branch)
@@ -1572,30 +2960,11 @@ void CodeGen8086::handle_if_stmt(std::shared_ptr<IFBranch> branch)
     std::shared_ptr<BODYBranch> body_branch = branch->getBodyBranch();
 
 
-    // Process the expression of the "IF" statement
-    make_expression(exp_branch, &s_info);
-
-    // AX now contains true or false 
-    std::string true_label = build_unique_label();
     std::string false_label = build_unique_label();
     std::string end_label = build_unique_label();
 
-    // Handle any compare expression
-    if (this->is_cmp_expression)
-    {
-        // This is for expressions such as if(x == 1)
-        true_label = this->cmp_exp_true_label_name;
-        false_label = this->cmp_exp_false_label_name;
-        this->is_cmp_expression = false;
-    }
-    else
-    {
-        // This is for expressions such as if(x == 1 || x == 2)
-        do_asm("cmp ax, 0");
-        do_asm("je " + false_label);
-    }
-    // This is where we will jump if its true
-    make_exact_label(true_label);
+    // Process the expression of the "IF" statement, jumping straight to the false label should it not hold
+    make_condition_jump(exp_branch, &s_info, false, false_label);
 
     calculate_scope_size(body_branch);
 
@@ -1639,13 +3008,24 @@ void CodeGen8086::handle_for_stmt(std::shared_ptr<FORBranch> branch)
 {
     struct stmt_info s_info;
 
+    // Simple fill and copy loops can be done with a single string instruction
+    if (make_block_loop(branch))
+    {
+        return;
+    }
+
+    // Loops with a known trip count can count down in CX
+    if (make_counted_loop(branch))
+    {
+        return;
+    }
+
     do_asm("; FOR STATEMENT");
     std::shared_ptr<Branch> init_branch = branch->getInitBranch();
     std::shared_ptr<Branch> cond_branch = branch->getCondBranch();
     std::shared_ptr<Branch> loop_branch = branch->getLoopBranch();
     std::shared_ptr<Branch> body_branch = branch->getBodyBranch();
 
-    std::string true_label = build_unique_label();
     std::string false_label = build_unique_label();
     std::string loop_label = build_unique_label();
     // The part of the loop that may modify a variable
@@ -1663,29 +3043,23 @@ void CodeGen8086::handle_for_stmt(std::shared_ptr<FORBranch> branch)
     // Handle the init branch.
     handle_stmt(&s_info, init_branch);
 
-    // This is the label where it will jump if the expression is true
-    make_exact_label(loop_label);
-
-    // Make the condition branches expression
-    make_expression(cond_branch, &s_info);
-
-    // Handle the compare expression
-    handle_compare_expression();
-
-    if (this->is_cmp_expression)
-    {
-        true_label = this->cmp_exp_true_label_name;
-        false_label = this->cmp_exp_false_label_name;
-        this->is_cmp_expression = false;
-    }
-    else
+    // Is the variable modified by the loop branch an induction variable we can strength reduce?
+    bool has_induction_variable = false;
+    if (loop_branch->getType() == "ASSIGN")
     {
-        do_asm("cmp ax, 0");
-        do_asm("je " + false_label);
+        std::shared_ptr<Branch> var_branch = std::dynamic_pointer_cast<AssignBranch>(loop_branch)->getVariableToAssignBranch();
+        if (var_branch->getType() == "VAR_IDENTIFIER")
+        {
+            std::vector<std::shared_ptr<Branch>> loop_parts = {cond_branch, body_branch, loop_branch};
+            has_induction_variable = setup_induction_variable(std::dynamic_pointer_cast<VarIdentifierBranch>(var_branch)->getVariableDefinitionBranch(), loop_branch, loop_parts);
+        }
     }
 
-    // This is where we will jump if its true
-    make_exact_label(true_label);
+    // This is the label where it will jump if the expression is true
+    make_exact_label(loop_label);
+
+    // Make the condition branches expression, we will jump to the false label when it no longer holds
+    make_condition_jump(cond_branch, &s_info, false, false_label);
 
     // Handle the "FOR" statements body.
     handle_body(&s_info, body_branch);
@@ -1710,6 +3084,11 @@ void CodeGen8086::handle_for_stmt(std::shared_ptr<FORBranch> branch)
     // We are done with the continue label.
     end_continue_label();
 
+    if (has_induction_variable)
+    {
+        end_induction_variable();
+    }
+
     reset_scope_size();
 
 }
@@ -1721,7 +3100,6 @@ void CodeGen8086::handle_while_stmt(std::shared_ptr<WhileBranch> branch)
     std::shared_ptr<BODYBranch> body_branch = branch->getBodyBranch();
 
     std::string exp_label = build_unique_label();
-    std::string true_label = build_unique_label();
     std::string false_label = build_unique_label();
 
     // We need to create a new breakable label as you can break from "WHILE" statements
@@ -1730,30 +3108,33 @@ void CodeGen8086::handle_while_stmt(std::shared_ptr<WhileBranch> branch)
     // We need to setup expression labels for the continue label.
     new_continue_label(exp_label, body_branch);
 
+    /* Loops such as "while(message[i] != 0) { i += 1; }" step an induction variable in the body,
+     * if we find one we may be able to strength reduce it */
+    bool has_induction_variable = false;
+    for (std::shared_ptr<Branch> child : body_branch->getChildren())
+    {
+        if (child->getType() == "ASSIGN")
+        {
+            std::shared_ptr<Branch> var_branch = std::dynamic_pointer_cast<AssignBranch>(child)->getVariableToAssignBranch();
+            if (var_branch->getType() == "VAR_IDENTIFIER")
+            {
+                std::vector<std::shared_ptr<Branch>> loop_parts = {exp_branch, body_branch};
+                has_induction_variable = setup_induction_variable(std::dynamic_pointer_cast<VarIdentifierBranch>(var_branch)->getVariableDefinitionBranch(), child, loop_parts);
+                if (has_induction_variable)
+                {
+                    break;
+                }
+            }
+        }
+    }
+
     make_exact_label(exp_label);
 
-    // Process the expression of the "WHILE" statement
-    make_expression(exp_branch, &s_info);
+    // Process the expression of the "WHILE" statement, jumping straight to the false label should it not hold
+    make_condition_jump(exp_branch, &s_info, false, false_label);
 
-    if (this->is_cmp_expression)
-    {
-        // This would be the case for expressions such as while(x != 0)
-        true_label = this->cmp_exp_true_label_name;
-        false_label = this->cmp_exp_false_label_name;
-        this->is_cmp_expression = false;
-    }
-    else
-    {
-        /* This would be the case for expressions such as while(x != 0 || y != 3), they would have been previously handled 
-         * meaning we need to compare the result to zero*/
-        do_asm("cmp ax, 0");
-        do_asm("je " + false_label);
-    }
     calculate_scope_size(body_branch);
 
-    // This is where we will jump if its true
-    make_exact_label(true_label);
-
     // Handle the "WHILE" statements body.
     handle_body(&s_info, body_branch);
 
@@ -1771,6 +3152,174 @@ void CodeGen8086::handle_while_stmt(std::shared_ptr<WhileBranch> branch)
     end_breakable_label();
 
     end_continue_label();
+
+    if (has_induction_variable)
+    {
+        end_induction_variable();
+    }
+}
+
+void CodeGen8086::handle_switch_stmt(std::shared_ptr<SwitchBranch> branch)
+{
+    struct stmt_info s_info;
+    std::shared_ptr<Branch> exp_branch = branch->getExpressionBranch();
+    std::shared_ptr<BODYBranch> body_branch = branch->getBodyBranch();
+
+    // We can break from "SWITCH" statements, continuing is left to the loop we are in if any
+    new_breakable_label(body_branch);
+
+    /* Every case gets a label that is made where the case appears in the body, 
+     * the values are compared as words so a case of -1 is 0xffff */
+    std::vector<std::pair<unsigned int, std::string>> cases;
+    std::string default_label = "";
+    for (std::shared_ptr<Branch> child : body_branch->getChildren())
+    {
+        if (child->getType() == "CASE")
+        {
+            std::string case_label = build_unique_label();
+            unsigned int value = std::stoi(std::dynamic_pointer_cast<CaseBranch>(child)->getValueBranch()->getValue()) & 0xffff;
+            cases.push_back(std::make_pair(value, case_label));
+            this->switch_labels[child] = case_label;
+        }
+        else if (child->getType() == "DEFAULT")
+        {
+            default_label = build_unique_label();
+            this->switch_labels[child] = default_label;
+        }
+    }
+    std::sort(cases.begin(), cases.end());
+
+    // Without a "default" we end up at the end of the body should no case match
+    std::string no_match_label = build_unique_label();
+    if (default_label == "")
+    {
+        default_label = no_match_label;
+    }
+
+    do_asm("; SWITCH");
+    make_expression(exp_branch, &s_info);
+
+    // The scope is reserved before we jump into the body so that breaking and falling out of it release the same amount
+    calculate_scope_size(body_branch);
+
+    if (cases.empty())
+    {
+        do_asm("jmp " + default_label);
+    }
+    else if (is_switch_dense(cases))
+    {
+        make_switch_jump_table(cases, default_label);
+        this->total_jump_tables++;
+    }
+    else
+    {
+        make_switch_compare_tree(cases, 0, cases.size(), default_label);
+        this->total_compare_trees++;
+    }
+
+    // Handle the "SWITCH" statements body, the cases will make their labels as we go
+    handle_body(&s_info, body_branch);
+
+    make_exact_label(no_match_label);
+
+    reset_scope_size();
+
+    // Lets make the label for where we end up if we break
+    make_exact_label(this->breakable_label);
+
+    end_breakable_label();
+
+    for (std::shared_ptr<Branch> child : body_branch->getChildren())
+    {
+        this->switch_labels.erase(child);
+    }
+
+    this->total_switches++;
+}
+
+bool CodeGen8086::is_switch_dense(std::vector<std::pair<unsigned int, std::string>>& cases)
+{
+    if (cases.size() < SWITCH_JUMP_TABLE_MIN_CASES)
+    {
+        return false;
+    }
+
+    // The cases are sorted so the range is between the first and the last
+    unsigned int total_entries = cases.back().first - cases.front().first + 1;
+    return total_entries <= cases.size() * SWITCH_JUMP_TABLE_MAX_ENTRIES_PER_CASE;
+}
+
+void CodeGen8086::make_switch_jump_table(std::vector<std::pair<unsigned int, std::string>>& cases, std::string default_label)
+{
+    unsigned int lowest_value = cases.front().first;
+    unsigned int total_entries = cases.back().first - lowest_value + 1;
+    std::string in_range_label = build_unique_label();
+    std::string table_label = build_unique_label();
+
+    do_asm("; JUMP TABLE");
+    // AX holds the expression, making it relative to the lowest case means a single unsigned compare checks both bounds
+    if (lowest_value != 0)
+    {
+        do_asm("sub ax, " + std::to_string(lowest_value));
+    }
+    do_asm("cmp ax, " + std::to_string(total_entries - 1));
+    // Conditional jumps are short only so we jump over a near jump to the default
+    do_asm("jbe " + in_range_label);
+    do_asm("jmp " + default_label);
+    make_exact_label(in_range_label);
+    do_asm("mov bx, ax");
+    do_asm("add bx, bx");
+    do_asm("jmp [" + table_label + "+bx]");
+
+    // Values between the cases have no case of their own so lead to the default
+    if (!getCompiler()->hasArgument("packed"))
+    {
+        this->switch_jump_tables.push_back("align 2");
+    }
+    this->switch_jump_tables.push_back(table_label + ":");
+    int case_index = 0;
+    for (unsigned int i = 0; i < total_entries; i++)
+    {
+        if (cases[case_index].first == lowest_value + i)
+        {
+            this->switch_jump_tables.push_back("dw " + cases[case_index].second);
+            case_index++;
+        }
+        else
+        {
+            this->switch_jump_tables.push_back("dw " + default_label);
+        }
+    }
+}
+
+void CodeGen8086::make_switch_compare_tree(std::vector<std::pair<unsigned int, std::string>>& cases, int start, int end, std::string default_label)
+{
+    if (end - start <= SWITCH_COMPARE_TREE_MAX_LEAF_CASES)
+    {
+        // Few enough cases remain that we just compare them all, each conditional jump only skips the near jump that follows it
+        for (int i = start; i < end; i++)
+        {
+            std::string next_label = build_unique_label();
+            do_asm("cmp ax, " + std::to_string(cases[i].first));
+            do_asm("jne " + next_label);
+            do_asm("jmp " + cases[i].second);
+            make_exact_label(next_label);
+        }
+        do_asm("jmp " + default_label);
+        return;
+    }
+
+    // Divide the cases in half, the lower half is compared straight after this and the upper half after that
+    int middle = start + (end - start) / 2;
+    std::string lower_label = build_unique_label();
+    std::string upper_label = build_unique_label();
+    do_asm("cmp ax, " + std::to_string(cases[middle].first));
+    do_asm("jb " + lower_label);
+    do_asm("jmp " + upper_label);
+    make_exact_label(lower_label);
+    make_switch_compare_tree(cases, start, middle, default_label);
+    make_exact_label(upper_label);
+    make_switch_compare_tree(cases, middle, end, default_label);
 }
 
 void CodeGen8086::handle_break(std::shared_ptr<BreakBranch> branch)
@@ -1778,34 +3327,34 @@ void CodeGen8086::handle_break(std::shared_ptr<BreakBranch> branch)
     do_asm("; BREAK");
     // Looks like we are breaking out of this
     std::shared_ptr<Branch> branch_to_stop = this->breakable_branch_to_stop_reset;
-    do_asm("add sp, " + std::to_string(branch->getLocalScope()->getScopeSize(GET_SCOPE_SIZE_INCLUDE_PARENT_SCOPES, NULL,
-                                                                             [&](std::shared_ptr<Branch> branch) -> bool
-                                                                             {
-                                                                                 // We should stop at the function arguments so it doesn't include any more parent scopes when it reaches this point
-                                                                                 if (branch == branch_to_stop)
-                                                                                 {
-                                                                                     return false;
-                                                                                 }
-
-                                                                                 return true;
-                                                                             })));
+    make_stack_release(branch->getLocalScope()->getScopeSize(GET_SCOPE_SIZE_INCLUDE_PARENT_SCOPES, NULL,
+                                                             [&](std::shared_ptr<Branch> branch) -> bool
+                                                             {
+                                                                 // We should stop at the function arguments so it doesn't include any more parent scopes when it reaches this point
+                                                                 if (branch == branch_to_stop)
+                                                                 {
+                                                                     return false;
+                                                                 }
+
+                                                                 return true;
+                                                             }));
     do_asm("jmp " + this->breakable_label);
 }
 
 void CodeGen8086::handle_continue(std::shared_ptr<ContinueBranch> branch)
 {
     std::shared_ptr<Branch> branch_to_stop = this->continue_branch_to_stop_reset;
-    do_asm("add sp, " + std::to_string(branch->getLocalScope()->getScopeSize(GET_SCOPE_SIZE_INCLUDE_PARENT_SCOPES, NULL,
-                                                                             [&](std::shared_ptr<Branch> branch) -> bool
-                                                                             {
-                                                                                 // We should stop at the function arguments so it doesn't include any more parent scopes when it reaches this point
-                                                                                 if (branch == branch_to_stop)
-                                                                                 {
-                                                                                     return false;
-                                                                                 }
-
-                                                                                 return true;
-                                                                             })));
+    make_stack_release(branch->getLocalScope()->getScopeSize(GET_SCOPE_SIZE_INCLUDE_PARENT_SCOPES, NULL,
+                                                             [&](std::shared_ptr<Branch> branch) -> bool
+                                                             {
+                                                                 // We should stop at the function arguments so it doesn't include any more parent scopes when it reaches this point
+                                                                 if (branch == branch_to_stop)
+                                                                 {
+                                                                     return false;
+                                                                 }
+
+                                                                 return true;
+                                                             }));
     do_asm("jmp " + this->continue_label);
 }
 
@@ -1814,6 +3363,18 @@ void CodeGen8086::handle_array_index(struct stmt_info* s_info, std::shared_ptr<A
     do_asm("; ARRAY INDEX");
     // The current array index the framework needs us to resolve it at runtime.
     std::shared_ptr<Branch> child = array_index_branch->getValueBranch();
+
+    // Indexing by the induction variable of the loop we are in? then SI already holds the offset
+    if (this->induction_vdef != NULL
+            && this->induction_base_vdef == NULL
+            && this->induction_elem_size == elem_size
+            && !array_index_branch->hasNextArrayIndexBranch()
+            && is_var_iden_for(child, this->induction_vdef))
+    {
+        do_asm("mov di, si");
+        return;
+    }
+
     // Save AX incase previously used
     do_asm("push ax");
     if (child->getType() == "E")
@@ -1826,8 +3387,7 @@ void CodeGen8086::handle_array_index(struct stmt_info* s_info, std::shared_ptr<A
         make_move_reg_variable("ax", std::dynamic_pointer_cast<VarIdentifierBranch>(child), s_info);
     }
     // Ok now we need to multiply AX by the element size so that the offset points correctly
-    do_asm("mov cx, " + std::to_string(elem_size));
-    do_asm("mul cx");
+    make_scale_register("ax", elem_size);
     do_asm("mov di, ax");
     // Restore AX
     do_asm("pop ax");
@@ -2018,10 +3578,135 @@ void CodeGen8086::handle_next_access(struct stmt_info* s_info, struct VARIABLE_A
 
 }
 
+bool CodeGen8086::begin_address_capture()
+{
+    // Addresses computed while working out another address, such as in array indexes, are part of the outer capture
+    if (this->is_capturing_address)
+        return false;
+
+    this->is_capturing_address = true;
+    this->captured_address_asm.clear();
+    return true;
+}
+
+void CodeGen8086::end_address_capture()
+{
+    this->is_capturing_address = false;
+
+    std::string address_asm = "";
+    bool is_reusable = true;
+    for (std::string asm_ins : this->captured_address_asm)
+    {
+        if (asm_ins.find(";") == 0)
+            continue;
+
+        if (!is_bx_address_load(asm_ins, address_asm == ""))
+        {
+            is_reusable = false;
+        }
+        address_asm += asm_ins + "\n";
+    }
+
+    if (is_reusable && address_asm != "" && address_asm == this->bx_address)
+    {
+        // BX still holds this address from the last time we computed it
+        do_asm("; ADDRESS ALREADY IN BX");
+        this->total_reused_addresses++;
+        return;
+    }
+
+    for (std::string asm_ins : this->captured_address_asm)
+    {
+        do_asm(asm_ins);
+    }
+
+    if (is_reusable)
+    {
+        this->bx_address = address_asm;
+    }
+}
+
+bool CodeGen8086::is_bx_address_load(std::string asm_ins, bool is_first)
+{
+    /* Only addresses made purely of loads into BX relative to BP, the data segment or BX itself can be reused.
+     * Anything else such as an index in DI depends on registers we do not track */
+    if (asm_ins.find("mov bx, [") != 0 && asm_ins.find("lea bx, [") != 0)
+        return false;
+
+    if (asm_ins.find("di") != std::string::npos || asm_ins.find("si") != std::string::npos)
+        return false;
+
+    // The first load must not depend on what BX held before we started
+    if (is_first && asm_ins.find("[bx") != std::string::npos)
+        return false;
+
+    return true;
+}
+
+bool CodeGen8086::is_bx_preserved_by(std::string asm_ins)
+{
+    size_t start = asm_ins.find_first_not_of(" \t");
+    if (start == std::string::npos || asm_ins[start] == ';')
+        return true;
+
+    // Labels start a new basic block that can be jumped to with anything in BX
+    if (asm_ins[asm_ins.size() - 1] == ':')
+        return false;
+
+    size_t end = asm_ins.find(' ', start);
+    std::string op = asm_ins.substr(start, end == std::string::npos ? std::string::npos : end - start);
+    if (op[0] == 'j' || op == "loop" || op == "push" || op == "cmp" || op == "test"
+            || op == "mul" || op == "imul" || op == "div" || op == "idiv" || op == "cbw" || op == "cwd")
+        return true;
+
+    if (op != "mov" && op != "lea" && op != "add" && op != "adc" && op != "sub" && op != "sbb"
+            && op != "and" && op != "or" && op != "xor" && op != "inc" && op != "dec" && op != "neg" && op != "not"
+            && op != "shl" && op != "shr" && op != "sal" && op != "sar" && op != "rol" && op != "ror"
+            && op != "rcl" && op != "rcr" && op != "pop" && op != "xchg")
+        return false;
+
+    std::vector<std::string> dests;
+    std::string operands = end == std::string::npos ? "" : asm_ins.substr(end + 1);
+    size_t comma = operands.find(',');
+    dests.push_back(operands.substr(0, comma));
+    if (op == "xchg" && comma != std::string::npos)
+    {
+        dests.push_back(operands.substr(comma + 1));
+    }
+
+    for (std::string dest : dests)
+    {
+        // Any store to memory may change what BX was loaded from as we cannot tell which pointers alias
+        if (dest.find('[') != std::string::npos)
+            return false;
+
+        dest.erase(0, dest.find_first_not_of(" \t"));
+        dest.erase(dest.find_last_not_of(" \t") + 1);
+        if (dest == "bx" || dest == "bl" || dest == "bh" || dest == "bp")
+            return false;
+    }
+
+    return true;
+}
+
 struct VARIABLE_ADDRESS CodeGen8086::getASMAddressForVariable(struct stmt_info* s_info, std::shared_ptr<VarIdentifierBranch> root_var_branch, bool to_variable_start_only)
 {
     struct VARIABLE_ADDRESS address;
     address.apply_reg = "";
+
+    // Accessing the hoisted pointer with the induction variable of the loop we are in? then SI holds the address
+    if (this->induction_base_vdef != NULL
+            && !to_variable_start_only
+            && !s_info->is_child_of_pointer
+            && root_var_branch->getVariableDefinitionBranch() == this->induction_base_vdef
+            && get_indexed_elem_size(root_var_branch, this->induction_vdef) != 0)
+    {
+        address.segment = "si";
+        address.op = "+";
+        address.offset = 0;
+        return address;
+    }
+
     std::shared_ptr<VDEFBranch> top_vdef_branch = root_var_branch->getVariableDefinitionBranch(true);
     std::shared_ptr<VDEFBranch> vdef_branch = root_var_branch->getVariableDefinitionBranch();
     VARIABLE_TYPE var_type = vdef_branch->getVariableType();
@@ -2038,9 +3723,7 @@ struct VARIABLE_ADDRESS CodeGen8086::getASMAddressForVariable(struct stmt_info*
         switch (var_type)
         {
         case VARIABLE_TYPE_GLOBAL_VARIABLE:
-            address.segment = "_data";
-            address.op = "+";
-            address.offset = root_var_branch->getPositionRelZero(NULL, NULL);
+            address = get_global_variable_address(root_var_branch->getPositionRelZero(NULL, NULL));
             break;
         case VARIABLE_TYPE_FUNCTION_VARIABLE:
             if (!to_variable_start_only && (root_var_branch->hasStructureAccessBranch() || root_var_branch->hasRootArrayIndexBranch()))
@@ -2076,11 +3759,17 @@ struct VARIABLE_ADDRESS CodeGen8086::getASMAddressForVariable(struct stmt_info*
             break;
 
         }
+
+        if (this->cur_func_has_bx_frame && address.segment == "bp")
+        {
+            address = get_bx_frame_address(address);
+        }
     }
     else
     {
 
         // Ok the position is non-static we will need to deal with it at run time
+        bool is_capturing = begin_address_capture();
         address.segment = "bx";
         address.op = "+";
         address.offset = 0;
@@ -2122,7 +3811,7 @@ struct VARIABLE_ADDRESS CodeGen8086::getASMAddressForVariable(struct stmt_info*
                     if (failed_vdef_branch->isPointer() && !failed_vdef_branch->getVariableIdentifierBranch()->hasRootArrayIndexBranch())
                     {
                         // Lets load the pointer value
-                        do_asm("mov bx, [_data+" + std::to_string(position.abs) + "]");
+                        do_asm("mov bx, [" + get_global_variable_address(position.abs).to_string() + "]");
                         position.abs = 0;
                         do_point_first = true;
                         ignore_pointer = true;
@@ -2168,9 +3857,10 @@ struct VARIABLE_ADDRESS CodeGen8086::getASMAddressForVariable(struct stmt_info*
                         }
                         else
                         {
-                            address.segment = "_data";
-                            address.op = "+";
-                            address.offset = position.abs;
+                            struct VARIABLE_ADDRESS global_address = get_global_variable_address(position.abs);
+                            address.segment = global_address.segment;
+                            address.op = global_address.op;
+                            address.offset = global_address.offset;
                         }
                     }
 
@@ -2178,35 +3868,23 @@ struct VARIABLE_ADDRESS CodeGen8086::getASMAddressForVariable(struct stmt_info*
 
                 if (failed_var_iden->hasStructureAccessBranch())
                 {
-                    if (address.apply_reg != "")
+                    struct VARIABLE_ADDRESS global_address = get_global_variable_address(position.abs);
+                    global_address.apply_reg = address.apply_reg;
+                    if (do_lea)
                     {
-                        if (do_lea)
-                        {
-                            do_asm("lea bx, [_data+" + std::to_string(position.abs) + "+" + address.apply_reg + "]");
-                        }
-                        else
-                        {
-                            do_asm("mov bx, [_data+" + std::to_string(position.abs) + "+" + address.apply_reg + "]");
-                        }
-                        address.apply_reg = "";
+                        do_asm("lea bx, [" + global_address.to_string() + "]");
                     }
                     else
                     {
-                        if (do_lea)
-                        {
-                            do_asm("lea bx, [_data+" + std::to_string(position.abs) + "]");
-                        }
-                        else
-                        {
-                            do_asm("mov bx, [_data+" + std::to_string(position.abs) + "]");
-                        }
+                        do_asm("mov bx, [" + global_address.to_string() + "]");
                     }
+                    address.apply_reg = "";
                 }
             }
             else
             {
                 // There was no failed branch
-                do_asm("mov bx, [_data+" + std::to_string(position.abs) + "]");
+                do_asm("mov bx, [" + get_global_variable_address(position.abs).to_string() + "]");
             }
 
             // Is this access being accessed as a pointer? e.g *var[3].b If so we need to dig down
@@ -2492,6 +4170,11 @@ struct VARIABLE_ADDRESS CodeGen8086::getASMAddressForVariable(struct stmt_info*
             break;
 
         }
+
+        if (is_capturing)
+        {
+            end_address_capture();
+        }
     }
 
     return address;
@@ -2500,6 +4183,11 @@ struct VARIABLE_ADDRESS CodeGen8086::getASMAddressForVariable(struct stmt_info*
 
 std::string CodeGen8086::getASMAddressForVariableFormatted(struct stmt_info* s_info, std::shared_ptr<VarIdentifierBranch> root_var_branch, bool to_variable_start_only)
 {
+    if (get_held_argument_register(root_var_branch->getVariableDefinitionBranch()) != "")
+    {
+        throw CodeGeneratorException("std::string CodeGen8086::getASMAddressForVariableFormatted(struct stmt_info* s_info, std::shared_ptr<VarIdentifierBranch> root_var_branch, bool to_variable_start_only): arguments held in registers have no address");
+    }
+
     struct VARIABLE_ADDRESS address = getASMAddressForVariable(s_info, root_var_branch, to_variable_start_only);
     return address.to_string();
 }
@@ -2553,6 +4241,74 @@ bool CodeGen8086::is_alone_var_to_be_word(std::shared_ptr<VarIdentifierBranch> v
     return is_alone_var_to_be_word(vdef_branch, ignore_pointer);
 }
 
+void CodeGen8086::do_asm(std::string asm_ins, std::string segment)
+{
+    if (segment == "code")
+    {
+        if (this->is_capturing_address)
+        {
+            // We will decide what to do with these instructions once the address is complete
+            this->captured_address_asm.push_back(asm_ins);
+            return;
+        }
+
+        if (!is_bx_preserved_by(asm_ins))
+        {
+            this->bx_address = "";
+        }
+    }
+
+    CodeGenerator::do_asm(asm_ins, segment);
+}
+
+/* The 8086 fetches a word in one bus cycle only when it is on an even address, so words, pointers, 
+ * word arrays and structures in global memory or within structures are placed on even addresses unless we are told "-packed".
+ * Stack variables are left alone as the stack pointer is always even and arguments are already pushed as words. */
+int CodeGen8086::getVariableAlignment(std::shared_ptr<ScopeBranch> scope_branch, std::shared_ptr<VDEFBranch> vdef_branch)
+{
+    if (getCompiler()->hasArgument("packed"))
+    {
+        return 1;
+    }
+
+    bool is_global_scope = scope_branch->getType() == "root";
+    bool is_structure_scope = scope_branch->getParent() != NULL && scope_branch->getParent()->getType() == "STRUCT";
+    if (!is_global_scope && !is_structure_scope)
+    {
+        return 1;
+    }
+
+    if (vdef_branch->getDataTypeBranch()->getDataTypeSize() < 2)
+    {
+        return 1;
+    }
+
+    return 2;
+}
+
+void CodeGen8086::generate(std::shared_ptr<Tree> tree)
+{
+    CodeGenerator::generate(tree);
+
+    make_string_pool();
+
+    // The jump tables of switch statements go after everything else in the data segment
+    for (std::string table_asm : this->switch_jump_tables)
+    {
+        do_asm(table_asm, "data");
+    }
+
+    report("Stack frames elided: " + std::to_string(this->total_elided_frames) + " of " + std::to_string(this->total_functions) + " functions ("
+           + std::to_string(this->total_bx_frames) + " addressing the stack through BX)");
+    report("Register arguments held in registers: " + std::to_string(this->total_held_arguments));
+    report("Variable addresses reused from BX: " + std::to_string(this->total_reused_addresses));
+    report("Bytes of zero initialised globals reserved in bss: " + std::to_string(this->total_bss_bytes));
+    report("String literals: " + std::to_string(this->total_strings) + " (" + std::to_string(this->string_labels.size()) + " unique, "
+           + std::to_string(this->total_merged_strings) + " placed inside of longer strings)");
+    report("Switch statements: " + std::to_string(this->total_switches) + " (" + std::to_string(this->total_jump_tables)
+           + " jump tables, " + std::to_string(this->total_compare_trees) + " compare trees)");
+}
+
 void CodeGen8086::generate_global_branch(std::shared_ptr<Branch> branch)
 {
     // We don't really take advantage of this statement info here as this is not a statement, but we don't want to pass a NULL 
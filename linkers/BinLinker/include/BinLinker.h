@@ -25,21 +25,34 @@
 #ifndef BINLINKER_H
 #define BINLINKER_H
 
+#include <vector>
+#include <map>
+#include <string>
 #include "Linker.h"
 #include "VirtualObjectFormat.h"
 
+// mov di, start; mov cx, size; xor al, al; cld; rep stosb
+#define BSS_ZEROING_STUB_SIZE 11
+
 class BinLinker : public Linker {
 public:
     BinLinker(Compiler* compiler);
     virtual ~BinLinker();
 protected:
-    int countStreamSizesStopAtSegment(std::shared_ptr<VirtualObjectFormat> obj, std::shared_ptr<VirtualSegment> segment_to_stop);
+    void calculate_segment_addresses(std::shared_ptr<VirtualObjectFormat> obj);
+    int getSegmentAddress(std::shared_ptr<VirtualSegment> segment);
+    std::vector<std::shared_ptr<VirtualSegment>> getSegmentsInLoadOrder(std::shared_ptr<VirtualObjectFormat> obj);
+    int getStartupStubSize(std::shared_ptr<VirtualObjectFormat> obj);
+    void WriteStartupStub(Stream* executable_stream, std::shared_ptr<VirtualObjectFormat> final_obj);
     void WriteSegment(Stream* executable_stream, std::shared_ptr<VirtualSegment> segment);
+    void merge_strings(std::shared_ptr<VirtualObjectFormat> final_obj);
     virtual void resolve(std::shared_ptr<VirtualObjectFormat> final_obj);
     virtual void resolve_segment(std::shared_ptr<VirtualObjectFormat> final_obj, std::shared_ptr<VirtualSegment> segment);
+    void resolve_segment_part(std::shared_ptr<VirtualObjectFormat> final_obj, std::shared_ptr<VirtualSegment> part, int segment_abs_pos);
     virtual void build(Stream* executable_stream, std::shared_ptr<VirtualObjectFormat> final_obj);
 private:
-
+    // Key = segment name, value = the address of the segment in the executable before any origin is applied
+    std::map<std::string, int> segment_addresses;
 };
 
 #endif /* BINLINKER_H */
@@ -25,6 +25,7 @@
  */
 
 #include "BinLinker.h"
+#include "Compiler.h"
 #include "common.h"
 #include <iostream>
 
@@ -38,26 +39,275 @@ BinLinker::~BinLinker()
 
 void BinLinker::WriteSegment(Stream* executable_stream, std::shared_ptr<VirtualSegment> segment)
 {
-    std::shared_ptr<Stream> segment_stream = segment->getStream();
-    executable_stream->writeStream(segment_stream);
+    // Pad the executable so the segment starts on its alignment
+    while (executable_stream->getSize() % segment->getAlignment() != 0)
+    {
+        executable_stream->write8(0);
+    }
+
+    // Segments appended from other object files are written straight from their own streams, padded to where they start
+    size_t segment_start = executable_stream->getSize();
+    for (std::shared_ptr<VirtualSegment> part : segment->getParts())
+    {
+        while (executable_stream->getSize() < segment_start + segment->getPartPosition(part))
+        {
+            executable_stream->write8(0);
+        }
+        executable_stream->writeStream(part->getStream());
+    }
+}
+
+void BinLinker::WriteStartupStub(Stream* executable_stream, std::shared_ptr<VirtualObjectFormat> final_obj)
+{
+    // Uninitialized segments are placed last so we zero from the start of the first one to the end of the last one
+    std::shared_ptr<VirtualSegment> first_segment = NULL;
+    std::shared_ptr<VirtualSegment> last_segment = NULL;
+    for (std::shared_ptr<VirtualSegment> segment : getSegmentsInLoadOrder(final_obj))
+    {
+        if (segment->isUninitialized())
+        {
+            if (first_segment == NULL)
+            {
+                first_segment = segment;
+            }
+            last_segment = segment;
+        }
+    }
+
+    int start = getSegmentAddress(first_segment);
+    int end = getSegmentAddress(last_segment) + last_segment->getSize();
+
+    // mov di, start
+    executable_stream->write8(0xbf);
+    executable_stream->write16(start + first_segment->getOrigin());
+    // mov cx, size
+    executable_stream->write8(0xb9);
+    executable_stream->write16(end - start);
+    // xor al, al
+    executable_stream->write8(0x30);
+    executable_stream->write8(0xc0);
+    // cld
+    executable_stream->write8(0xfc);
+    // rep stosb
+    executable_stream->write8(0xf3);
+    executable_stream->write8(0xaa);
 }
 
-int BinLinker::countStreamSizesStopAtSegment(std::shared_ptr<VirtualObjectFormat> obj, std::shared_ptr<VirtualSegment> segment_to_stop)
+int BinLinker::getStartupStubSize(std::shared_ptr<VirtualObjectFormat> obj)
 {
-    int size = 0;
-    std::string segment_name_to_stop_at = segment_to_stop->getName();
+    // Zeroing is opt-in as the stub placed before the code changes where execution begins
+    if (!getCompiler()->hasArgument("bss_zeroing"))
+    {
+        return 0;
+    }
+
+    // The stub is only needed if there is something to zero
     for (std::shared_ptr<VirtualSegment> segment : obj->getSegments())
     {
-        if (segment->getName() == segment_name_to_stop_at)
-            break;
+        if (segment->isUninitialized() && segment->getSize() != 0)
+        {
+            return BSS_ZEROING_STUB_SIZE;
+        }
+    }
+
+    return 0;
+}
+
+std::vector<std::shared_ptr<VirtualSegment>> BinLinker::getSegmentsInLoadOrder(std::shared_ptr<VirtualObjectFormat> obj)
+{
+    /* The code segment goes first as execution begins at the start of the binary, 
+     * uninitialized segments go last so nothing after them needs their space stored in the binary */
+    std::vector<std::shared_ptr<VirtualSegment>> segments;
+    if (obj->hasSegment("code"))
+    {
+        segments.push_back(obj->getSegment("code"));
+    }
+
+    // Function sections follow so that all of the code is kept together
+    for (std::shared_ptr<VirtualSegment> segment : obj->getSegments())
+    {
+        if (segment->isFunctionSection())
+        {
+            segments.push_back(segment);
+        }
+    }
+
+    for (std::shared_ptr<VirtualSegment> segment : obj->getSegments())
+    {
+        if (segment->getName() != "code" && !segment->isFunctionSection() && !segment->isUninitialized())
+        {
+            segments.push_back(segment);
+        }
+    }
+
+    for (std::shared_ptr<VirtualSegment> segment : obj->getSegments())
+    {
+        if (segment->isUninitialized())
+        {
+            segments.push_back(segment);
+        }
+    }
+
+    return segments;
+}
+
+void BinLinker::calculate_segment_addresses(std::shared_ptr<VirtualObjectFormat> obj)
+{
+    this->segment_addresses.clear();
+
+    // The startup stub comes before everything else
+    int size = getStartupStubSize(obj);
+    for (std::shared_ptr<VirtualSegment> segment : getSegmentsInLoadOrder(obj))
+    {
+        // Segments are padded to their alignment when written so we must do the same here
+        while (size % segment->getAlignment() != 0)
+        {
+            size++;
+        }
+
+        this->segment_addresses[segment->getName()] = size;
+        size += segment->getSize();
+    }
+}
+
+int BinLinker::getSegmentAddress(std::shared_ptr<VirtualSegment> segment)
+{
+    // Fixups from merged objects still point to their original segment so we go by name
+    std::map<std::string, int>::iterator it = this->segment_addresses.find(segment->getName());
+    if (it == this->segment_addresses.end())
+    {
+        throw Exception("The segment: " + segment->getName() + " has not been given an address", "int BinLinker::getSegmentAddress(std::shared_ptr<VirtualSegment> segment)");
+    }
+
+    return it->second;
+}
+
+void BinLinker::merge_strings(std::shared_ptr<VirtualObjectFormat> final_obj)
+{
+    std::shared_ptr<VirtualSegment> strings_segment = final_obj->getSegment("strings");
+    // We need every string in one stream to merge them
+    strings_segment->materialize();
+    if (strings_segment->hasGlobalReferences())
+    {
+        throw Exception("The \"strings\" segment cannot be merged as it has global references", "void BinLinker::merge_strings(std::shared_ptr<VirtualObjectFormat> final_obj)");
+    }
 
-        size += segment->getStream()->getSize();
+    // Split the segment into its null terminated strings, key = offset the string starts at, value = the string
+    std::shared_ptr<Stream> stream = strings_segment->getStream();
+    std::map<int, std::string> strings;
+    std::string str = "";
+    int str_start = 0;
+    for (size_t i = 0; i < stream->getSize(); i++)
+    {
+        char c = stream->peek8(i);
+        if (c == 0)
+        {
+            strings[str_start] = str;
+            str = "";
+            str_start = i + 1;
+        }
+        else
+        {
+            str += c;
+        }
+    }
+
+    if (str != "")
+    {
+        throw Exception("The \"strings\" segment may only hold null terminated strings", "void BinLinker::merge_strings(std::shared_ptr<VirtualObjectFormat> final_obj)");
+    }
+
+    std::vector<std::string> unique_strings;
+    for (std::pair<int, std::string> string_pair : strings)
+    {
+        if (std::find(unique_strings.begin(), unique_strings.end(), string_pair.second) == unique_strings.end())
+        {
+            unique_strings.push_back(string_pair.second);
+        }
+    }
+
+    std::stable_sort(unique_strings.begin(), unique_strings.end(), [](const std::string& a, const std::string& b) -> bool
+    {
+        return a.length() > b.length();
+    });
+
+    // Write each string once, strings that are the end of a longer string are pointed inside of it
+    std::shared_ptr<Stream> merged_stream = std::shared_ptr<Stream>(new Stream());
+    // Key = string, value = its offset in the merged stream
+    std::map<std::string, int> merged_offsets;
+    std::vector<std::string> written_strings;
+    for (std::string unique_str : unique_strings)
+    {
+        bool is_suffix = false;
+        for (std::string written_str : written_strings)
+        {
+            if (written_str.compare(written_str.length() - unique_str.length(), unique_str.length(), unique_str) == 0)
+            {
+                merged_offsets[unique_str] = merged_offsets[written_str] + (written_str.length() - unique_str.length());
+                is_suffix = true;
+                break;
+            }
+        }
+
+        if (!is_suffix)
+        {
+            merged_offsets[unique_str] = merged_stream->getSize();
+            merged_stream->writeStr(unique_str);
+            written_strings.push_back(unique_str);
+        }
+    }
+
+    // Anything pointing into the strings must now point into the merged strings
+    for (std::shared_ptr<VirtualSegment> segment : final_obj->getSegments())
+    {
+        for (std::shared_ptr<VirtualSegment> part : segment->getParts())
+        {
+            char* buf = part->getStream()->getBuf();
+            for (std::shared_ptr<FIXUP> fixup : get_sorted_fixups(part))
+            {
+                std::shared_ptr<FIXUP_TARGET> target = fixup->getTarget();
+                if (target->getType() != FIXUP_TARGET_TYPE_SEGMENT
+                        || std::dynamic_pointer_cast<FIXUP_TARGET_SEGMENT>(target)->getTargetSegment()->getName() != "strings")
+                {
+                    continue;
+                }
+
+                if (fixup->getType() != FIXUP_TYPE_SEGMENT)
+                {
+                    throw Exception("Only segment fixups may refer to the \"strings\" segment when merging strings", "void BinLinker::merge_strings(std::shared_ptr<VirtualObjectFormat> final_obj)");
+                }
+
+                int old_pos = read_fixup(part, buf, fixup);
+                // The fixup is relative to the strings of its own object file
+                old_pos += final_obj->getSegmentPosition(std::dynamic_pointer_cast<FIXUP_TARGET_SEGMENT>(target)->getTargetSegment());
+
+                // Find the string the old position was in, it may point part way into it
+                std::map<int, std::string>::iterator it = strings.upper_bound(old_pos);
+                if (it == strings.begin())
+                {
+                    throw Exception("A fixup points outside of the \"strings\" segment", "void BinLinker::merge_strings(std::shared_ptr<VirtualObjectFormat> final_obj)");
+                }
+                it--;
+                int new_pos = merged_offsets[it->second] + (old_pos - it->first);
+                apply_fixup(part, buf, fixup, new_pos);
+            }
+        }
     }
-    return size;
+
+    strings_segment->setStream(merged_stream);
 }
 
 void BinLinker::resolve(std::shared_ptr<VirtualObjectFormat> final_obj)
 {
+    // Strings in the "strings" segment of every object file can be merged before anything refers to their final position
+    if (getCompiler()->hasArgument("merge_strings") && final_obj->hasSegment("strings"))
+    {
+        merge_strings(final_obj);
+    }
+
+    // Segments no longer change size from here on so their addresses are worked out once for every fixup
+    calculate_segment_addresses(final_obj);
+
     // We should resolve the code segment first
     if (final_obj->hasSegment("code"))
     {
@@ -74,17 +324,27 @@ void BinLinker::resolve(std::shared_ptr<VirtualObjectFormat> final_obj)
 
 void BinLinker::resolve_segment(std::shared_ptr<VirtualObjectFormat> final_obj, std::shared_ptr<VirtualSegment> segment)
 {
-    int segment_abs_pos = countStreamSizesStopAtSegment(final_obj, segment);
-    std::shared_ptr<Stream> segment_stream = segment->getStream();
-    for (std::shared_ptr<FIXUP> fixup : segment->getFixups())
+    // Segments appended from other object files are resolved in their own streams
+    for (std::shared_ptr<VirtualSegment> part : segment->getParts())
+    {
+        resolve_segment_part(final_obj, part, getSegmentAddress(segment) + segment->getPartPosition(part));
+    }
+}
+
+void BinLinker::resolve_segment_part(std::shared_ptr<VirtualObjectFormat> final_obj, std::shared_ptr<VirtualSegment> part, int segment_abs_pos)
+{
+    // The fixups are applied straight to the bytes of the segment in the order they appear
+    char* buf = part->getStream()->getBuf();
+    for (std::shared_ptr<FIXUP> fixup : get_sorted_fixups(part))
     {
         int fixup_offset = fixup->getOffset();
         std::shared_ptr<FIXUP_TARGET> target = fixup->getTarget();
         if (target->getType() == FIXUP_TARGET_TYPE_SEGMENT)
         {
-            int diff, new_pos;
+            int diff;
             std::shared_ptr<FIXUP_TARGET_SEGMENT> fixup_target_segment = std::dynamic_pointer_cast<FIXUP_TARGET_SEGMENT>(target);
-            int target_seg_abs_pos = countStreamSizesStopAtSegment(final_obj, fixup_target_segment->getTargetSegment());
+            // The fixup is relative to the target segment of its own object file
+            int target_seg_abs_pos = getSegmentAddress(fixup_target_segment->getTargetSegment()) + final_obj->getSegmentPosition(fixup_target_segment->getTargetSegment());
             if (fixup->getType() == FIXUP_TYPE_SEGMENT)
             {
                 // This is a segment fixup, we are fixing up from the start of a segment
@@ -98,22 +358,7 @@ void BinLinker::resolve_segment(std::shared_ptr<VirtualObjectFormat> final_obj,
                 diff = distance_to_target_segment;
             }
 
-
-            switch (fixup->getLength())
-            {
-            case FIXUP_8BIT:
-                new_pos = diff + segment_stream->peek8(fixup_offset);
-                segment_stream->overwrite8(fixup_offset, new_pos);
-                break;
-            case FIXUP_16BIT:
-                new_pos = diff + segment_stream->peek16(fixup_offset);
-                segment_stream->overwrite16(fixup_offset, new_pos);
-                break;
-            case FIXUP_32BIT:
-                new_pos = diff + segment_stream->peek32(fixup_offset);
-                segment_stream->overwrite32(fixup_offset, new_pos);
-                break;
-            }
+            apply_fixup(part, buf, fixup, diff + read_fixup(part, buf, fixup));
         }
         else if (target->getType() == FIXUP_TARGET_TYPE_EXTERN)
         {
@@ -124,7 +369,7 @@ void BinLinker::resolve_segment(std::shared_ptr<VirtualObjectFormat> final_obj,
             {
                 throw Exception("The reference: " + reference_name + " could not be resolved");
             }
-            int global_ref_seg_abs_pos = countStreamSizesStopAtSegment(final_obj, global_ref->getSegment());
+            int global_ref_seg_abs_pos = getSegmentAddress(global_ref->getSegment()) + final_obj->getSegmentPosition(global_ref->getSegment());
             int global_ref_abs_pos = global_ref_seg_abs_pos + global_ref->getOffset();
             int new_pos;
             if (fixup->getType() == FIXUP_TYPE_SEGMENT)
@@ -138,37 +383,35 @@ void BinLinker::resolve_segment(std::shared_ptr<VirtualObjectFormat> final_obj,
                 new_pos = distance_to_global_ref;
             }
 
-            switch (fixup->getLength())
-            {
-            case FIXUP_8BIT:
-                segment_stream->overwrite8(fixup_offset, new_pos);
-                break;
-            case FIXUP_16BIT:
-                segment_stream->overwrite16(fixup_offset, new_pos);
-                break;
-            case FIXUP_32BIT:
-                segment_stream->overwrite32(fixup_offset, new_pos);
-                break;
-            }
-
+            apply_fixup(part, buf, fixup, new_pos);
         }
     }
 }
 
 void BinLinker::build(Stream* executable_stream, std::shared_ptr<VirtualObjectFormat> final_obj)
 {
-    // Lets prioritise the code segment
-    std::shared_ptr<VirtualSegment> code_segment = final_obj->getSegment("code");
-    WriteSegment(executable_stream, code_segment);
-
+    // Zero the uninitialized segments before the code runs when asked to as nothing is loaded there
+    if (getStartupStubSize(final_obj) != 0)
+    {
+        WriteStartupStub(executable_stream, final_obj);
+    }
+    else
+    {
+        for (std::shared_ptr<VirtualSegment> segment : final_obj->getSegments())
+        {
+            if (segment->isUninitialized() && segment->getSize() != 0)
+            {
+                warn("The uninitialized segment \"" + segment->getName() + "\" (" + std::to_string(segment->getSize()) + " bytes) is not stored in the binary and will not be zeroed, link with -bss_zeroing to zero it");
+            }
+        }
+    }
 
-    // Now lets write all other segments
-    for (std::shared_ptr<VirtualSegment> segment : final_obj->getSegments())
+    for (std::shared_ptr<VirtualSegment> segment : getSegmentsInLoadOrder(final_obj))
     {
-        // We have already processed segment code
-        if (segment->getName() == "code")
-            continue;
+        // Uninitialized segments come last and take no space in the binary
+        if (segment->isUninitialized())
+            break;
 
         WriteSegment(executable_stream, segment);
     }
-}
\ No newline at end of file
+}
\ No newline at end of file
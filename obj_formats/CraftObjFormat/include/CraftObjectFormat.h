@@ -0,0 +1,115 @@
+/*
+    Craft compiler v0.1.0 - The standard compiler for the Craft programming language.
+    Copyright (C) 2016  Daniel McCarthy
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* 
+ * File:   CraftObjectFormat.h
+ * Author: Daniel McCarthy
+ *
+ * Created on 18 October 2026, 20:10
+ */
+
+#ifndef CRAFTOBJECTFORMAT_H
+#define CRAFTOBJECTFORMAT_H
+#include <stdint.h>
+#include <map>
+#include "VirtualObjectFormat.h"
+
+#define CRAFT_OBJECT_SIGNATURE "COBJ"
+#define CRAFT_OBJECT_VERSION 1
+
+// Segment flags
+#define CRAFT_OBJECT_SEGMENT_UNINITIALIZED 0x01
+
+/* Every record is a fixed size and every table starts on a four byte boundary so that 
+ * a loaded or mapped file can be used in place. Numbers are little endian.
+ * Names are offsets into the string table which holds null terminated strings. */
+struct CRAFT_OBJECT_HEADER
+{
+    char signature[4];
+    uint16_t version;
+    uint16_t flags;
+    uint32_t total_segments;
+    uint32_t total_fixups;
+    uint32_t total_symbols;
+    uint32_t total_externs;
+    uint32_t segments_offset;
+    uint32_t fixups_offset;
+    uint32_t symbols_offset;
+    uint32_t externs_offset;
+    uint32_t strings_offset;
+    uint32_t strings_size;
+};
+
+struct CRAFT_OBJECT_SEGMENT
+{
+    uint32_t name;
+    // Where the segment data begins in the file, uninitialized segments have no data only a size
+    uint32_t data_offset;
+    uint32_t size;
+    uint16_t alignment;
+    uint16_t flags;
+    // The fixups of a segment are next to each other in the fixup table
+    uint32_t first_fixup;
+    uint32_t total_fixups;
+};
+
+struct CRAFT_OBJECT_FIXUP
+{
+    uint32_t offset;
+    // A segment index or an extern index depending on the target type
+    uint32_t target;
+    uint8_t type;
+    uint8_t length;
+    uint8_t target_type;
+    uint8_t reserved;
+};
+
+struct CRAFT_OBJECT_SYMBOL
+{
+    uint32_t name;
+    uint32_t segment;
+    uint32_t offset;
+};
+
+struct CRAFT_OBJECT_EXTERN
+{
+    uint32_t name;
+};
+
+class EXPORT CraftObjectFormat : public VirtualObjectFormat
+{
+public:
+    CraftObjectFormat(Compiler* compiler);
+    virtual ~CraftObjectFormat();
+
+    virtual std::shared_ptr<VirtualSegment> new_segment(std::string segment_name, uint32_t origin);
+    virtual void read(std::shared_ptr<Stream> input_stream);
+    virtual void finalize();
+
+private:
+    const char* get_string(struct CRAFT_OBJECT_HEADER* header, char* buf, uint32_t offset);
+    void check_table(size_t buf_size, uint32_t offset, uint32_t total, size_t entry_size, std::string table_name);
+    uint32_t add_string(std::string str);
+    void align_stream(Stream* stream);
+
+    // Key = a string in the string table, value = its offset in the string table
+    std::map<std::string, uint32_t> string_offsets;
+    Stream string_table;
+};
+
+#endif /* CRAFTOBJECTFORMAT_H */
+
@@ -0,0 +1,337 @@
+/*
+    Craft compiler v0.1.0 - The standard compiler for the Craft programming language.
+    Copyright (C) 2016  Daniel McCarthy
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* 
+ * File:   CraftObjectFormat.cpp
+ * Author: Daniel McCarthy
+ *
+ * Created on 18 October 2026, 20:10
+ * 
+ * Description: The native object format of the Craft compiler. 
+ * 
+ * Unlike OMF there are no variable length records to translate, the file is a header followed by
+ * tables of fixed size entries, a string table and then the segment data. Reading walks the tables where they lie in the loaded buffer.
+ */
+
+#include <string>
+#include <vector>
+#include <cstring>
+
+#include "CraftObjectFormat.h"
+#include "Compiler.h"
+
+CraftObjectFormat::CraftObjectFormat(Compiler* compiler) : VirtualObjectFormat(compiler)
+{
+}
+
+CraftObjectFormat::~CraftObjectFormat()
+{
+}
+
+std::shared_ptr<VirtualSegment> CraftObjectFormat::new_segment(std::string segment_name, uint32_t origin)
+{
+    // We are not doing anything special so lets just return the standard virtual segment
+    return std::shared_ptr<VirtualSegment>(new VirtualSegment(segment_name, origin));
+}
+
+const char* CraftObjectFormat::get_string(struct CRAFT_OBJECT_HEADER* header, char* buf, uint32_t offset)
+{
+    if (offset >= header->strings_size)
+    {
+        throw Exception("A name in the craft object file is outside of the string table", "const char* CraftObjectFormat::get_string(struct CRAFT_OBJECT_HEADER* header, char* buf, uint32_t offset)");
+    }
+
+    return buf + header->strings_offset + offset;
+}
+
+void CraftObjectFormat::check_table(size_t buf_size, uint32_t offset, uint32_t total, size_t entry_size, std::string table_name)
+{
+    // Tables are read where they are so their entries must be aligned
+    if (entry_size > 1 && offset % 4 != 0)
+    {
+        throw Exception("The " + table_name + " table of the craft object file is not aligned", "void CraftObjectFormat::check_table(size_t buf_size, uint32_t offset, uint32_t total, size_t entry_size, std::string table_name)");
+    }
+
+    if ((uint64_t) offset + (uint64_t) total * entry_size > buf_size)
+    {
+        throw Exception("The " + table_name + " table goes beyond the end of the craft object file", "void CraftObjectFormat::check_table(size_t buf_size, uint32_t offset, uint32_t total, size_t entry_size, std::string table_name)");
+    }
+}
+
+uint32_t CraftObjectFormat::add_string(std::string str)
+{
+    std::map<std::string, uint32_t>::iterator it = this->string_offsets.find(str);
+    if (it != this->string_offsets.end())
+    {
+        return it->second;
+    }
+
+    uint32_t offset = this->string_table.getSize();
+    this->string_table.writeStr(str);
+    this->string_offsets[str] = offset;
+    return offset;
+}
+
+void CraftObjectFormat::align_stream(Stream* stream)
+{
+    while (stream->getSize() % 4 != 0)
+    {
+        stream->write8(0);
+    }
+}
+
+void CraftObjectFormat::read(std::shared_ptr<Stream> input_stream)
+{
+    char* buf = input_stream->getBuf();
+    size_t buf_size = input_stream->getSize();
+    if (buf_size < sizeof (struct CRAFT_OBJECT_HEADER) || memcmp(buf, CRAFT_OBJECT_SIGNATURE, 4) != 0)
+    {
+        throw Exception("The stream is not a craft object file", "void CraftObjectFormat::read(std::shared_ptr<Stream> input_stream)");
+    }
+
+    struct CRAFT_OBJECT_HEADER* header = (struct CRAFT_OBJECT_HEADER*) buf;
+    if (header->version != CRAFT_OBJECT_VERSION)
+    {
+        throw Exception("Craft object files of version " + std::to_string(header->version) + " are not supported", "void CraftObjectFormat::read(std::shared_ptr<Stream> input_stream)");
+    }
+
+    // Check every table once here so that the entries can be trusted below
+    check_table(buf_size, header->segments_offset, header->total_segments, sizeof (struct CRAFT_OBJECT_SEGMENT), "segment");
+    check_table(buf_size, header->fixups_offset, header->total_fixups, sizeof (struct CRAFT_OBJECT_FIXUP), "fixup");
+    check_table(buf_size, header->symbols_offset, header->total_symbols, sizeof (struct CRAFT_OBJECT_SYMBOL), "symbol");
+    check_table(buf_size, header->externs_offset, header->total_externs, sizeof (struct CRAFT_OBJECT_EXTERN), "extern");
+    check_table(buf_size, header->strings_offset, header->strings_size, 1, "string");
+    if (header->strings_size != 0 && buf[header->strings_offset + header->strings_size - 1] != 0)
+    {
+        throw Exception("The string table of the craft object file is not null terminated", "void CraftObjectFormat::read(std::shared_ptr<Stream> input_stream)");
+    }
+
+    struct CRAFT_OBJECT_SEGMENT* segment_entries = (struct CRAFT_OBJECT_SEGMENT*) (buf + header->segments_offset);
+    struct CRAFT_OBJECT_FIXUP* fixup_entries = (struct CRAFT_OBJECT_FIXUP*) (buf + header->fixups_offset);
+    struct CRAFT_OBJECT_SYMBOL* symbol_entries = (struct CRAFT_OBJECT_SYMBOL*) (buf + header->symbols_offset);
+    struct CRAFT_OBJECT_EXTERN* extern_entries = (struct CRAFT_OBJECT_EXTERN*) (buf + header->externs_offset);
+
+    // All segments must exist before any fixups as fixups may target segments that come later
+    std::vector<std::shared_ptr<VirtualSegment>> segments;
+    for (uint32_t i = 0; i < header->total_segments; i++)
+    {
+        struct CRAFT_OBJECT_SEGMENT* entry = &segment_entries[i];
+        std::shared_ptr<VirtualSegment> segment = VirtualObjectFormat::createSegment(get_string(header, buf, entry->name));
+        segment->setAlignment(entry->alignment);
+        if (entry->flags & CRAFT_OBJECT_SEGMENT_UNINITIALIZED)
+        {
+            segment->setUninitialized(true);
+            segment->reserve(entry->size);
+        }
+        else
+        {
+            if ((uint64_t) entry->data_offset + entry->size > buf_size)
+            {
+                throw Exception("The data of the segment: " + segment->getName() + " goes beyond the end of the craft object file", "void CraftObjectFormat::read(std::shared_ptr<Stream> input_stream)");
+            }
+
+            segment->getStream()->writeBuf(buf + entry->data_offset, entry->size);
+        }
+        segments.push_back(segment);
+    }
+
+    for (uint32_t i = 0; i < header->total_externs; i++)
+    {
+        VirtualObjectFormat::registerExternalReference(get_string(header, buf, extern_entries[i].name));
+    }
+
+    for (uint32_t i = 0; i < header->total_segments; i++)
+    {
+        struct CRAFT_OBJECT_SEGMENT* entry = &segment_entries[i];
+        if ((uint64_t) entry->first_fixup + entry->total_fixups > header->total_fixups)
+        {
+            throw Exception("The fixups of the segment: " + segments[i]->getName() + " are outside of the fixup table", "void CraftObjectFormat::read(std::shared_ptr<Stream> input_stream)");
+        }
+
+        for (uint32_t f = entry->first_fixup; f < entry->first_fixup + entry->total_fixups; f++)
+        {
+            struct CRAFT_OBJECT_FIXUP* fixup = &fixup_entries[f];
+            if (fixup->length != FIXUP_8BIT && fixup->length != FIXUP_16BIT && fixup->length != FIXUP_32BIT)
+            {
+                throw Exception("Unsupported fixup length provided in craft object file", "void CraftObjectFormat::read(std::shared_ptr<Stream> input_stream)");
+            }
+
+            if (fixup->type != FIXUP_TYPE_SELF_RELATIVE && fixup->type != FIXUP_TYPE_SEGMENT)
+            {
+                throw Exception("Unsupported fixup type provided in craft object file", "void CraftObjectFormat::read(std::shared_ptr<Stream> input_stream)");
+            }
+
+            if (fixup->target_type == FIXUP_TARGET_TYPE_SEGMENT && fixup->target < header->total_segments)
+            {
+                segments[i]->register_fixup_target_segment(fixup->type, segments[fixup->target], fixup->offset, fixup->length);
+            }
+            else if (fixup->target_type == FIXUP_TARGET_TYPE_EXTERN && fixup->target < header->total_externs)
+            {
+                segments[i]->register_fixup_target_extern(fixup->type, get_string(header, buf, extern_entries[fixup->target].name), fixup->offset, fixup->length);
+            }
+            else
+            {
+                throw Exception("A fixup in the craft object file has an invalid target", "void CraftObjectFormat::read(std::shared_ptr<Stream> input_stream)");
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < header->total_symbols; i++)
+    {
+        struct CRAFT_OBJECT_SYMBOL* symbol = &symbol_entries[i];
+        if (symbol->segment >= header->total_segments)
+        {
+            throw Exception("A symbol in the craft object file belongs to a segment that does not exist", "void CraftObjectFormat::read(std::shared_ptr<Stream> input_stream)");
+        }
+        if (symbol->offset > (uint32_t) segments[symbol->segment]->getSize())
+        {
+            throw Exception("A symbol in the craft object file is beyond the end of its segment: " + segments[symbol->segment]->getName(), "void CraftObjectFormat::read(std::shared_ptr<Stream> input_stream)");
+        }
+        VirtualObjectFormat::registerGlobalReference(segments[symbol->segment], get_string(header, buf, symbol->name), symbol->offset);
+    }
+}
+
+void CraftObjectFormat::finalize()
+{
+    std::vector<std::shared_ptr<VirtualSegment>> segments = getSegments();
+    std::vector<std::string> externs = getExternalReferences();
+
+    // Key = segment name, value = its index in the segment table
+    std::map<std::string, uint32_t> segment_indexes;
+    uint32_t total_fixups = 0;
+    uint32_t total_symbols = 0;
+    for (uint32_t i = 0; i < segments.size(); i++)
+    {
+        segment_indexes[segments[i]->getName()] = i;
+        total_fixups += segments[i]->getFixups().size();
+        total_symbols += segments[i]->getGlobalReferences().size();
+        add_string(segments[i]->getName());
+        for (std::shared_ptr<GLOBAL_REF> global_ref : segments[i]->getGlobalReferences())
+        {
+            add_string(global_ref->getName());
+        }
+    }
+
+    // Key = external reference name, value = its index in the extern table
+    std::map<std::string, uint32_t> extern_indexes;
+    for (uint32_t i = 0; i < externs.size(); i++)
+    {
+        extern_indexes[externs[i]] = i;
+        add_string(externs[i]);
+    }
+
+    // Work out where everything goes, the entries are all multiples of four bytes so the tables stay aligned
+    uint32_t segments_offset = sizeof (struct CRAFT_OBJECT_HEADER);
+    uint32_t fixups_offset = segments_offset + segments.size() * sizeof (struct CRAFT_OBJECT_SEGMENT);
+    uint32_t symbols_offset = fixups_offset + total_fixups * sizeof (struct CRAFT_OBJECT_FIXUP);
+    uint32_t externs_offset = symbols_offset + total_symbols * sizeof (struct CRAFT_OBJECT_SYMBOL);
+    uint32_t strings_offset = externs_offset + externs.size() * sizeof (struct CRAFT_OBJECT_EXTERN);
+    uint32_t data_offset = strings_offset + this->string_table.getSize();
+    data_offset += (4 - data_offset % 4) % 4;
+
+    Stream* stream = getObjectStream();
+    stream->writeStr(CRAFT_OBJECT_SIGNATURE, false);
+    stream->write16(CRAFT_OBJECT_VERSION);
+    stream->write16(0);
+    stream->write32(segments.size());
+    stream->write32(total_fixups);
+    stream->write32(total_symbols);
+    stream->write32(externs.size());
+    stream->write32(segments_offset);
+    stream->write32(fixups_offset);
+    stream->write32(symbols_offset);
+    stream->write32(externs_offset);
+    stream->write32(strings_offset);
+    stream->write32(this->string_table.getSize());
+
+    uint32_t first_fixup = 0;
+    for (std::shared_ptr<VirtualSegment> segment : segments)
+    {
+        stream->write32(add_string(segment->getName()));
+        stream->write32(segment->isUninitialized() ? 0 : data_offset);
+        stream->write32(segment->getSize());
+        stream->write16(segment->getAlignment());
+        stream->write16(segment->isUninitialized() ? CRAFT_OBJECT_SEGMENT_UNINITIALIZED : 0);
+        stream->write32(first_fixup);
+        stream->write32(segment->getFixups().size());
+        first_fixup += segment->getFixups().size();
+        if (!segment->isUninitialized())
+        {
+            data_offset += segment->getSize();
+        }
+    }
+
+    for (std::shared_ptr<VirtualSegment> segment : segments)
+    {
+        for (std::shared_ptr<FIXUP> fixup : segment->getFixups())
+        {
+            std::shared_ptr<FIXUP_TARGET> fixup_target = fixup->getTarget();
+            uint32_t target;
+            if (fixup_target->getType() == FIXUP_TARGET_TYPE_SEGMENT)
+            {
+                std::string target_name = std::dynamic_pointer_cast<FIXUP_TARGET_SEGMENT>(fixup_target)->getTargetSegment()->getName();
+                if (segment_indexes.find(target_name) == segment_indexes.end())
+                {
+                    throw Exception("The fixup targets the segment: " + target_name + " which is not part of this object file", "void CraftObjectFormat::finalize()");
+                }
+                target = segment_indexes[target_name];
+            }
+            else
+            {
+                std::string extern_name = std::dynamic_pointer_cast<FIXUP_TARGET_EXTERN>(fixup_target)->getExternalName();
+                if (extern_indexes.find(extern_name) == extern_indexes.end())
+                {
+                    throw Exception("The fixup targets: " + extern_name + " which was never registered as an external reference", "void CraftObjectFormat::finalize()");
+                }
+                target = extern_indexes[extern_name];
+            }
+
+            stream->write32(fixup->getOffset());
+            stream->write32(target);
+            stream->write8(fixup->getType());
+            stream->write8(fixup->getLength());
+            stream->write8(fixup_target->getType());
+            stream->write8(0);
+        }
+    }
+
+    for (uint32_t i = 0; i < segments.size(); i++)
+    {
+        for (std::shared_ptr<GLOBAL_REF> global_ref : segments[i]->getGlobalReferences())
+        {
+            stream->write32(add_string(global_ref->getName()));
+            stream->write32(i);
+            stream->write32(global_ref->getOffset());
+        }
+    }
+
+    for (std::string external_ref : externs)
+    {
+        stream->write32(add_string(external_ref));
+    }
+
+    stream->writeStream(&this->string_table);
+    align_stream(stream);
+
+    for (std::shared_ptr<VirtualSegment> segment : segments)
+    {
+        if (!segment->isUninitialized())
+        {
+            stream->writeStream(segment->getStream());
+        }
+    }
+}
@@ -24,6 +24,7 @@
 
 #ifndef OMFOBJECTFORMAT_H
 #define OMFOBJECTFORMAT_H
+#include <map>
 #include "MagicOMF.h"
 #include "VirtualObjectFormat.h"
 
@@ -41,8 +42,13 @@ public:
 private:
     LOCATION_TYPE get_location_type_from_fixup(std::shared_ptr<FIXUP> fixup);
     FIXUP_MODE get_fixup_mode_from_fixup(std::shared_ptr<FIXUP> fixup);
-    void handle_segment_fixup(struct RECORD* record, std::shared_ptr<FIXUP> fixup, std::shared_ptr<FIXUP_TARGET_SEGMENT> fixup_target_seg);
-    void handle_extern_fixup(struct RECORD* record, std::shared_ptr<FIXUP> fixup, std::shared_ptr<FIXUP_TARGET_EXTERN> fixup_target_extern);
+    unsigned char get_alignment_attribute_from_segment(std::shared_ptr<VirtualSegment> segment);
+    int get_alignment_from_attribute(unsigned char attribute);
+    void handle_segment_fixup(struct RECORD* record, std::shared_ptr<FIXUP> fixup, std::shared_ptr<FIXUP_TARGET_SEGMENT> fixup_target_seg, int ledata_offset);
+    void handle_extern_fixup(struct RECORD* record, std::shared_ptr<FIXUP> fixup, std::shared_ptr<FIXUP_TARGET_EXTERN> fixup_target_extern, int ledata_offset);
+    int get_ledata_end(std::vector<std::shared_ptr<FIXUP>>& fixups, size_t fixup_index, int ledata_pos, int data_size);
+    std::shared_ptr<VirtualSegment> get_segment_for_segdef(std::map<struct SEGDEF_16*, std::shared_ptr<VirtualSegment>>* segdef_segments, struct SEGDEF_16* segdef_16);
+    int get_data_size_to_write(std::shared_ptr<VirtualSegment> segment, std::vector<std::shared_ptr<FIXUP>>& fixups);
 };
 
 #endif /* OMFOBJECTFORMAT_H */
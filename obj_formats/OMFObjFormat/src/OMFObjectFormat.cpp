@@ -25,9 +25,32 @@
  */
 
 #include <string>
+#include <map>
+#include <algorithm>
+#include <mutex>
+#include <cstdlib>
+#include <cstring>
 
 #include "OMFObjectFormat.h"
 #include "Compiler.h"
+#include "common.h"
+
+/* MagicOMF makes no promise that it is thread safe and object files are read on several threads,
+ * so only one thread may call into it at a time. The records of a handle belong to the thread that translated them
+ * so walking them needs no lock */
+static std::mutex magic_omf_mutex;
+
+static struct MagicOMFHandle* translate_locked(char* buf, size_t size)
+{
+    std::lock_guard<std::mutex> lock(magic_omf_mutex);
+    return MagicOMFTranslate(buf, size, true);
+}
+
+static void close_handle_locked(struct MagicOMFHandle* handle)
+{
+    std::lock_guard<std::mutex> lock(magic_omf_mutex);
+    MagicOMFCloseHandle(handle);
+}
 
 OMFObjectFormat::OMFObjectFormat(Compiler* compiler) : VirtualObjectFormat(compiler)
 {
@@ -81,38 +104,132 @@ FIXUP_MODE OMFObjectFormat::get_fixup_mode_from_fixup(std::shared_ptr<FIXUP> fix
     return mode;
 }
 
-void OMFObjectFormat::handle_segment_fixup(struct RECORD* record, std::shared_ptr<FIXUP> fixup, std::shared_ptr<FIXUP_TARGET_SEGMENT> fixup_target_seg)
+unsigned char OMFObjectFormat::get_alignment_attribute_from_segment(std::shared_ptr<VirtualSegment> segment)
+{
+    // OMF can only describe a few alignments so we use the next one up that satisfies the segment
+    int alignment = segment->getAlignment();
+    if (alignment <= 1)
+    {
+        return SEG_ATTR_ALIGNMENT_RELOC_BYTE_ALIGNED;
+    }
+    else if (alignment <= 2)
+    {
+        return SEG_ATTR_ALIGNMENT_RELOC_WORD_ALIGNED;
+    }
+    else if (alignment <= 16)
+    {
+        return SEG_ATTR_ALIGNMENT_RELOC_PARAGRAPH_ALIGNED;
+    }
+    else if (alignment <= 256)
+    {
+        return SEG_ATTR_ALIGNMENT_RELOC_PAGE_ALIGNED;
+    }
+
+    throw Exception("The segment \"" + segment->getName() + "\" has an alignment of " + std::to_string(alignment)
+                    + " which is more than the OMF(Object Module Format) can describe", "unsigned char OMFObjectFormat::get_alignment_attribute_from_segment(std::shared_ptr<VirtualSegment> segment)");
+}
+
+int OMFObjectFormat::get_alignment_from_attribute(unsigned char attribute)
+{
+    switch (attribute)
+    {
+    case SEG_ATTR_ALIGNMENT_RELOC_WORD_ALIGNED:
+        return 2;
+    case SEG_ATTR_ALIGNMENT_RELOC_PARAGRAPH_ALIGNED:
+        return 16;
+    case SEG_ATTR_ALIGNMENT_RELOC_PAGE_ALIGNED:
+        return 256;
+    }
+
+    return 1;
+}
+
+void OMFObjectFormat::handle_segment_fixup(struct RECORD* record, std::shared_ptr<FIXUP> fixup, std::shared_ptr<FIXUP_TARGET_SEGMENT> fixup_target_seg, int ledata_offset)
 {
     LOCATION_TYPE location_type = get_location_type_from_fixup(fixup);
     FIXUP_MODE mode = get_fixup_mode_from_fixup(fixup);
     MagicOMFAddFIXUP16_SubRecord_Segment_Fixup(record,
                                                fixup_target_seg->getTargetSegment()->getName().c_str(),
-                                               fixup->getOffset(),
+                                               fixup->getOffset() - ledata_offset,
                                                location_type,
                                                mode);
 }
 
-void OMFObjectFormat::handle_extern_fixup(struct RECORD* record, std::shared_ptr<FIXUP> fixup, std::shared_ptr<FIXUP_TARGET_EXTERN> fixup_target_extern)
+void OMFObjectFormat::handle_extern_fixup(struct RECORD* record, std::shared_ptr<FIXUP> fixup, std::shared_ptr<FIXUP_TARGET_EXTERN> fixup_target_extern, int ledata_offset)
 {
     LOCATION_TYPE location_type = get_location_type_from_fixup(fixup);
     FIXUP_MODE mode = get_fixup_mode_from_fixup(fixup);
     MagicOMFAddFIXUP16_SubRecord_External_Fixup(record,
                                                 fixup_target_extern->getExternalName().c_str(),
-                                                fixup->getOffset(),
+                                                fixup->getOffset() - ledata_offset,
                                                 location_type,
                                                 mode);
 }
 
+int OMFObjectFormat::get_ledata_end(std::vector<std::shared_ptr<FIXUP>>& fixups, size_t fixup_index, int ledata_pos, int data_size)
+{
+    // Fill the LEDATA as far as we can but a fixup may not be split between two LEDATA records, so we stop before one that would be
+    int ledata_end = std::min(ledata_pos + MAX_LEDATA_SIZE, data_size);
+    for (size_t i = fixup_index; i < fixups.size() && fixups[i]->getOffset() < ledata_end; i++)
+    {
+        if (fixups[i]->getOffset() + GetFixupLengthAsInteger(fixups[i]->getLength()) > ledata_end)
+        {
+            return fixups[i]->getOffset();
+        }
+    }
+
+    return ledata_end;
+}
+
+int OMFObjectFormat::get_data_size_to_write(std::shared_ptr<VirtualSegment> segment, std::vector<std::shared_ptr<FIXUP>>& fixups)
+{
+    /* Zeros at the end of a segment are not written, its SEGDEF length covers them and readers fill them in.
+     * At least one byte is written so the segment is not mistaken for an uninitialized one */
+    std::shared_ptr<Stream> stream = segment->getStream();
+    char* buf = stream->getBuf();
+    int data_size = stream->getSize();
+    while (data_size > 1 && buf[data_size - 1] == 0)
+    {
+        data_size--;
+    }
+
+    // Bytes that are to be fixed up must still be written even if they are zero
+    if (!fixups.empty())
+    {
+        std::shared_ptr<FIXUP> last_fixup = fixups.back();
+        data_size = std::max(data_size, last_fixup->getOffset() + GetFixupLengthAsInteger(last_fixup->getLength()));
+    }
+
+    return data_size;
+}
+
+std::shared_ptr<VirtualSegment> OMFObjectFormat::get_segment_for_segdef(std::map<struct SEGDEF_16*, std::shared_ptr<VirtualSegment>>* segdef_segments, struct SEGDEF_16* segdef_16)
+{
+    std::map<struct SEGDEF_16*, std::shared_ptr<VirtualSegment>>::iterator it = segdef_segments->find(segdef_16);
+    if (it == segdef_segments->end())
+    {
+        throw Exception("A record in the OMF file refers to a segment that was not defined before it", "std::shared_ptr<VirtualSegment> OMFObjectFormat::get_segment_for_segdef(std::map<struct SEGDEF_16*, std::shared_ptr<VirtualSegment>>* segdef_segments, struct SEGDEF_16* segdef_16)");
+    }
+
+    return it->second;
+}
+
 void OMFObjectFormat::read(std::shared_ptr<Stream> input_stream)
 {
     char* buf = input_stream->getBuf();
-    struct MagicOMFHandle* handle = MagicOMFTranslate(buf, input_stream->getSize(), true);
+    struct MagicOMFHandle* handle = translate_locked(buf, input_stream->getSize());
+    // The records are only needed until we have copied what we want out of them, this frees them however we leave
+    std::unique_ptr<struct MagicOMFHandle, void(*)(struct MagicOMFHandle*)> handle_owner(handle, close_handle_locked);
     if (handle->has_error)
     {
         throw Exception("Problem reading OMF file: " + std::string(GetErrorMessage(handle->last_error_code))
                         , "void OMFObjectFormat::read(std::shared_ptr<Stream> input_stream)");
     }
 
+    // Key = segment name, value = the segment length its SEGDEF states
+    std::map<std::string, int> segment_lengths;
+    // Records refer to their segments by SEGDEF so we remember the segment made for each one rather than search by name
+    std::map<struct SEGDEF_16*, std::shared_ptr<VirtualSegment>> segdef_segments;
     struct RECORD* current = handle->root;
     while (current != NULL)
     {
@@ -121,19 +238,17 @@ void OMFObjectFormat::read(std::shared_ptr<Stream> input_stream)
         case SEGDEF_16_ID:
         {
             struct SEGDEF_16* segdef_16 = (struct SEGDEF_16*) current->contents;
-            VirtualObjectFormat::createSegment(segdef_16->class_name_str);
+            std::shared_ptr<VirtualSegment> segment = VirtualObjectFormat::createSegment(segdef_16->class_name_str);
+            segdef_segments[segdef_16] = segment;
+            segment->setAlignment(get_alignment_from_attribute(segdef_16->attributes.A));
+            segment_lengths[segment->getName()] = segdef_16->seg_len;
         }
             break;
         case LEDATA_16_ID:
         {
             struct LEDATA_16* ledata_16 = (struct LEDATA_16*) current->contents;
-            std::shared_ptr<VirtualSegment> segment = VirtualObjectFormat::getSegment(ledata_16->SEGDEF_16_record->class_name_str);
-            std::shared_ptr<Stream> stream = segment->getStream();
-            char* buf = ledata_16->data_bytes;
-            for (int i = 0; i < ledata_16->data_bytes_size; i++)
-            {
-                stream->write8(buf[i]);
-            }
+            std::shared_ptr<VirtualSegment> segment = get_segment_for_segdef(&segdef_segments, ledata_16->SEGDEF_16_record);
+            segment->getStream()->writeBuf(ledata_16->data_bytes, ledata_16->data_bytes_size);
         }
             break;
         case EXTDEF_ID:
@@ -145,7 +260,7 @@ void OMFObjectFormat::read(std::shared_ptr<Stream> input_stream)
         case PUBDEF_16_ID:
         {
             struct PUBDEF_16* pubdef_16 = (struct PUBDEF_16*) current->contents;
-            std::shared_ptr<VirtualSegment> segment = VirtualObjectFormat::getSegment(pubdef_16->segdef_16_record->class_name_str);
+            std::shared_ptr<VirtualSegment> segment = get_segment_for_segdef(&segdef_segments, pubdef_16->segdef_16_record);
             struct PUBDEF_16_IDEN* current_iden = pubdef_16->iden;
             while (current_iden != NULL)
             {
@@ -162,7 +277,7 @@ void OMFObjectFormat::read(std::shared_ptr<Stream> input_stream)
                 if (fixup_16_desc->subrecord_type == FIXUPP_FIXUP_SUBRECORD)
                 {
                     struct FIXUPP_16_FIXUP_SUBRECORD* subrecord = (struct FIXUPP_16_FIXUP_SUBRECORD*) fixup_16_desc->subrecord;
-                    std::shared_ptr<VirtualSegment> target_segment = VirtualObjectFormat::getSegment(subrecord->target_data->SEGDEF_16_record->class_name_str);
+                    std::shared_ptr<VirtualSegment> target_segment = get_segment_for_segdef(&segdef_segments, subrecord->target_data->SEGDEF_16_record);
                     FIXUP_LENGTH length;
                     if (subrecord->location == FIXUPP_LOCATION_LOW_ORDER_BYTE_8_BIT_DISPLACEMENT)
                     {
@@ -196,7 +311,7 @@ void OMFObjectFormat::read(std::shared_ptr<Stream> input_stream)
                     else if (subrecord->target_type == FIXUPP_TARGET_TYPE_SEGIDX)
                     {
                         // Internal fixup
-                        std::shared_ptr<VirtualSegment> relating_segment = VirtualObjectFormat::getSegment(subrecord->relating_data->SEGDEF_16_record->class_name_str);
+                        std::shared_ptr<VirtualSegment> relating_segment = get_segment_for_segdef(&segdef_segments, subrecord->relating_data->SEGDEF_16_record);
                         target_segment->register_fixup_target_segment(fixup_type, relating_segment, subrecord->abs_data_record_offset, length);
                     }
                 }
@@ -209,6 +324,27 @@ void OMFObjectFormat::read(std::shared_ptr<Stream> input_stream)
         current = current->next;
     }
 
+    // Segments that have a length but were given no LEDATA records are uninitialized
+    for (std::shared_ptr<VirtualSegment> segment : getSegments())
+    {
+        int length = segment_lengths[segment->getName()];
+        std::shared_ptr<Stream> stream = segment->getStream();
+        if (length != 0 && stream->getSize() == 0)
+        {
+            segment->setUninitialized(true);
+            segment->reserve(length);
+        }
+        else
+        {
+            // Trailing zeros are not written to LEDATA records so we put them back
+            stream->setPosition(stream->getSize());
+            while (stream->getSize() < (size_t) length)
+            {
+                stream->write8(0);
+            }
+        }
+    }
+
 }
 
 void OMFObjectFormat::finalize()
@@ -240,11 +376,12 @@ void OMFObjectFormat::finalize()
     for (std::shared_ptr<VirtualSegment> segment : getSegments())
     {
         struct Attributes attributes;
-        attributes.A = SEG_ATTR_ALIGNMENT_RELOC_BYTE_ALIGNED;
+        attributes.A = get_alignment_attribute_from_segment(segment);
         attributes.C = SEG_ATTR_COMBINATION_PUBLIC_2;
         attributes.B = 0;
         attributes.P = SEG_ATTR_P_USE16;
-        MagicOMFAddSEGDEF16(handle, segment->getName().c_str(), attributes, segment->getStream()->getSize());
+        // Uninitialized segments are described by their size alone, they have no LEDATA records
+        MagicOMFAddSEGDEF16(handle, segment->getName().c_str(), attributes, segment->getSize());
     }
 
     // We should write any pubdef records for global definitions
@@ -273,72 +410,55 @@ void OMFObjectFormat::finalize()
         MagicOMFFinishEXTDEF(record);
     }
 
-    // We don't want to lose the memory chunks as the memory will be freed by the smart pointer. A bit of a hack storing all the chunks but this will work for now
-    std::vector<std::shared_ptr < Stream>> all_chunks;
-
     // Now we need to create the LEDATA records
     for (std::shared_ptr<VirtualSegment> segment : getSegments())
     {
-        std::shared_ptr<Stream> stream = segment->getStream();
-        // LEDATA records have a maximum of 1024 bytes so we need to split the stream into 1024 byte chunks
-        std::vector<std::shared_ptr < Stream>> stream_chunks = stream->chunkSplit(MAX_LEDATA_SIZE);
-        // Fixups for the stream chunks
-        std::vector<std::vector<std::shared_ptr < FIXUP>>> fixup_chunks;
-        fixup_chunks.resize(stream_chunks.size());
-        // We must organise the fixups and relocate their offsets for the pacific stream chunks
-        for (std::shared_ptr<FIXUP> fixup : segment->getFixups())
+        if (segment->isUninitialized())
         {
-            // We should solve the below problem as soon as possible
-            if (fixup->getLength() >= 2
-                    && fixup->getOffset() == MAX_LEDATA_SIZE - 1)
-            {
-                throw Exception("Fixup offset is " + std::to_string(MAX_LEDATA_SIZE - 1)
-                                + " and has a length of 2 bytes. This is impossible to resolve as a LEDATA's maximum size is " + std::to_string(MAX_LEDATA_SIZE)
-                                + " in the future the OMF(Object Module Format) library will push the data to another LEDATA record but for now this is unimplemented."
-                                + " just re-adjust your code so that the fixup will be at a different position.", "void OMFObjectFormat::finalize()");
-            }
-
-            // Calculate the index in the fixup_chunks vector where this fixup should be pushed to
-            int fixup_index = fixup->getOffset() / MAX_LEDATA_SIZE;
-            // We must now readjust the fixup offset
-            int offset_to_remove = 0;
-            for (int i = 0; i < fixup_index; i++)
-            {
-                offset_to_remove += stream_chunks[i]->getSize();
-            }
-            fixup->setOffset(fixup->getOffset() - offset_to_remove);
-            fixup_chunks[fixup_index].push_back(fixup);
+            continue;
         }
 
-        int ledatas_pos = 0;
-        for (int i = 0; i < stream_chunks.size(); i++)
+        char* buf = segment->getStream()->getBuf();
+        // Sorted by offset so each LEDATA record takes the fixups that follow on from the last
+        std::vector<std::shared_ptr<FIXUP>> fixups = segment->getFixups();
+        std::stable_sort(fixups.begin(), fixups.end(), [](std::shared_ptr<FIXUP> fixup1, std::shared_ptr<FIXUP> fixup2) -> bool
         {
-            std::shared_ptr<Stream> chunk_stream = stream_chunks[i];
-            // We want to save the chunk stream so it is not released at the end of this scope, this is a bit hacky I should change it soon
-            all_chunks.push_back(chunk_stream);
+            return fixup1->getOffset() < fixup2->getOffset();
+        });
 
-            MagicOMFAddLEDATA16(handle, segment->getName().c_str(), ledatas_pos, chunk_stream->getSize(), chunk_stream->getBuf());
-            // Do we have any fixups for this LEDATA?
-            if (!fixup_chunks[i].empty())
+        int data_size = get_data_size_to_write(segment, fixups);
+        size_t fixup_index = 0;
+        int ledata_pos = 0;
+        while (ledata_pos < data_size)
+        {
+            int ledata_end = get_ledata_end(fixups, fixup_index, ledata_pos, data_size);
+            /* MagicOMF keeps the data pointer it is given rather than copying the bytes, and closing the handle may free it.
+             * So MagicOMF is given its own heap copy and never a pointer into the segment stream */
+            char* data_bytes = (char*) malloc(ledata_end - ledata_pos);
+            memcpy(data_bytes, buf + ledata_pos, ledata_end - ledata_pos);
+            MagicOMFAddLEDATA16(handle, segment->getName().c_str(), ledata_pos, ledata_end - ledata_pos, data_bytes);
+            // All the fixups for this LEDATA go in the one FIXUPP record that follows it
+            if (fixup_index < fixups.size() && fixups[fixup_index]->getOffset() < ledata_end)
             {
                 struct RECORD* record = MagicOMFNewFIXUP16Record(handle);
-                for (std::shared_ptr<FIXUP> fixup : fixup_chunks[i])
+                for (; fixup_index < fixups.size() && fixups[fixup_index]->getOffset() < ledata_end; fixup_index++)
                 {
+                    std::shared_ptr<FIXUP> fixup = fixups[fixup_index];
                     std::shared_ptr<FIXUP_TARGET> fixup_target = fixup->getTarget();
                     switch (fixup_target->getType())
                     {
                     case FIXUP_TARGET_TYPE_SEGMENT:
-                        handle_segment_fixup(record, fixup, std::dynamic_pointer_cast<FIXUP_TARGET_SEGMENT>(fixup_target));
+                        handle_segment_fixup(record, fixup, std::dynamic_pointer_cast<FIXUP_TARGET_SEGMENT>(fixup_target), ledata_pos);
                         break;
                     case FIXUP_TARGET_TYPE_EXTERN:
-                        handle_extern_fixup(record, fixup, std::dynamic_pointer_cast<FIXUP_TARGET_EXTERN>(fixup_target));
+                        handle_extern_fixup(record, fixup, std::dynamic_pointer_cast<FIXUP_TARGET_EXTERN>(fixup_target), ledata_pos);
                         break;
                     }
                 }
                 MagicOMFFinishFIXUP16(record);
             }
 
-            ledatas_pos += chunk_stream->getSize();
+            ledata_pos = ledata_end;
         }
     }
 
@@ -350,9 +470,7 @@ void OMFObjectFormat::finalize()
     MagicOMFGenerateBuffer(handle);
 
     // We now have the OMF object in the handles buffer
-    for (int i = 0; i < handle->buf_size; i++)
-    {
-        getObjectStream()->write8(handle->buf[i]);
-    }
+    getObjectStream()->writeBuf(handle->buf, handle->buf_size);
+    MagicOMFCloseHandle(handle);
 
 }
\ No newline at end of file